@@ -0,0 +1,31 @@
+#!/bin/sh
+# Benchmark volani funkci: porovna vychozi volaci konvenci s --stack-calls
+#
+# Pouziti: bench/calls.sh [interpret]
+#   interpret  cesta k interpretu IFJcode18 (vychozi $IC18INT, jinak ic18int)
+#   COMPILER   cesta k prekladaci (vychozi ./compiler)
+
+cd "$(dirname "$0")/.." || exit 1
+
+COMPILER=${COMPILER:-./compiler}
+INTERPRET=${1:-${IC18INT:-ic18int}}
+CALLS=18361	# pocet volani uzivatelskych funkci v bench/calls.ifj
+
+TMP=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMP"' EXIT
+
+for MODE in "" "--stack-calls"; do
+	$COMPILER $MODE < bench/calls.ifj > "$TMP/calls.code" || exit 1
+
+	START=$(date +%s%N)
+	$INTERPRET "$TMP/calls.code" > "$TMP/calls.res" < /dev/null
+	END=$(date +%s%N)
+
+	if ! cmp -s "$TMP/calls.res" bench/calls.out; then
+		echo "${MODE:-default}: chybny vystup" >&2
+		exit 1
+	fi
+
+	awk -v mode="${MODE:-default}" -v calls=$CALLS -v ns=$((END - START)) \
+		'BEGIN { printf "%-14s %8.3f s %12.0f volani/s\n", mode, ns / 1e9, calls / (ns / 1e9) }'
+done
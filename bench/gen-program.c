@@ -0,0 +1,247 @@
+/**
+ * @file gen-program.c
+ *
+ * Generátor velkých programů v jazyce IFJ18 pro měření rychlosti překladu
+ *
+ * Stejné parametry (včetně --seed) dávají vždy stejný program. Program je
+ * syntakticky i sémanticky správný a po spuštění skončí (funkce volají jen
+ * dříve definované funkce, cykly mají pevný počet průchodů), je ale určený
+ * hlavně pro překlad - doba běhu roste s --nesting exponenciálně.
+ *
+ * Použití: gen-program [--functions n] [--statements n] [--vars n]
+ *                      [--expr-depth n] [--string-size n] [--nesting n]
+ *                      [--comments procenta] [--seed n] > program.ifj
+ *
+ * IFJ Projekt 2018, Tým 13
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/**
+ * Parametry generovaného programu
+ */
+typedef struct GenOptions{
+	int functions;		//!< Počet funkcí
+	int statements;		//!< Počet příkazů v těle funkce (a v hlavním těle)
+	int vars;			//!< Počet celočíselných a řetězcových proměnných ve funkci
+	int exprDepth;		//!< Největší hloubka vnoření výrazů
+	int stringSize;		//!< Délka řetězcových literálů
+	int nesting;		//!< Největší vnoření if/while
+	int comments;		//!< Pravděpodobnost komentáře před příkazem v procentech
+	uint64_t seed;		//!< Semínko generátoru náhodných čísel
+} tGenOptions;
+
+/**
+ * Stav generátoru náhodných čísel (xorshift64)
+ */
+static uint64_t genState;
+
+/**
+ * Náhodné číslo z intervalu <0, max)
+ */
+static int genRandom(int max){
+	genState ^= genState << 13;
+	genState ^= genState >> 7;
+	genState ^= genState << 17;
+	return max > 0 ? (int)(genState % (uint64_t)max) : 0;
+}
+
+/**
+ * Odsazení podle hloubky vnoření
+ */
+static void genIndent(int depth){
+	for(int i = 0; i < depth; i++) putchar('\t');
+}
+
+/**
+ * Celočíselný výraz nad proměnnými v0..v(vars-1), parametry a literály
+ */
+static void genExpr(const tGenOptions *opt, int depth, int params){
+	if(depth <= 0 || genRandom(4) == 0){
+		int pick = genRandom(3);
+		if(pick == 0) printf("%d", genRandom(1000));
+		else if(pick == 1 && params > 0) printf("%c", 'a' + genRandom(params));
+		else printf("v%d", genRandom(opt->vars));
+		return;
+	}
+
+	// Bez dělení - program nesmí skončit chybou dělení nulou
+	static const char *ops[] = { "+", "-", "*" };
+	putchar('(');
+	genExpr(opt, depth - 1, params);
+	printf(" %s ", ops[genRandom(3)]);
+	genExpr(opt, depth - 1, params);
+	putchar(')');
+}
+
+/**
+ * Řetězcový literál délky opt->stringSize (jen tisknutelné znaky a escape sekvence)
+ */
+static void genString(const tGenOptions *opt){
+	static const char chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 .,:;-_";
+	putchar('"');
+	for(int i = 0; i < opt->stringSize; i++){
+		int pick = genRandom(40);
+		if(pick == 0) printf("\\n");
+		else if(pick == 1) printf("\\x%02X", 0x20 + genRandom(0x5F));
+		else putchar(chars[genRandom(sizeof(chars) - 1)]);
+	}
+	putchar('"');
+}
+
+/**
+ * Komentář (řádkový, občas blokový) s pravděpodobností opt->comments
+ */
+static void genComment(const tGenOptions *opt, int depth){
+	if(genRandom(100) >= opt->comments) return;
+	if(genRandom(8) == 0){
+		// Blokový komentář musí začínat na začátku řádku
+		printf("=begin generated block comment\n  line with if while end def keywords\n=end\n");
+		return;
+	}
+	genIndent(depth);
+	printf("# generated comment %d with \"quotes\" and keywords if then end\n", genRandom(100000));
+}
+
+/**
+ * Blok příkazů
+ *
+ * @param func Index generované funkce (-1 = hlavní tělo, volá všechny funkce)
+ * @param params Počet parametrů funkce (a, b, ...)
+ * @param count Počet příkazů
+ * @param depth Odsazení
+ * @param nest Hloubka vnoření if/while
+ */
+static void genBlock(const tGenOptions *opt, int func, int params, int count, int depth, int nest){
+	int callable = func < 0 ? opt->functions : func;
+	// Funkce volá nejvýš jednu dřívější funkci, doba běhu tak roste s počtem funkcí lineárně
+	int calls = func < 0 ? count : 1;
+
+	for(int i = 0; i < count; i++){
+		genComment(opt, depth);
+		genIndent(depth);
+
+		int pick = genRandom(10);
+		if(pick < 2 && nest < opt->nesting && count > 1){
+			// if-else s částí zbývajících příkazů v každé větvi
+			int inner = 1 + genRandom(count - i);
+			printf("if ");
+			genExpr(opt, 1, params);
+			static const char *rels[] = { "<", ">", "<=", ">=", "==", "!=" };
+			printf(" %s ", rels[genRandom(6)]);
+			genExpr(opt, 1, params);
+			printf(" then\n");
+			genBlock(opt, func, params, inner, depth + 1, nest + 1);
+			genIndent(depth);
+			printf("else\n");
+			genBlock(opt, func, params, inner / 2 + 1, depth + 1, nest + 1);
+			genIndent(depth);
+			printf("end\n");
+			i += inner;
+		}else if(pick < 3 && nest < opt->nesting && count > 1){
+			// Cyklus se dvěma průchody (počítadlo podle hloubky, vnořené cykly se nepřepisují)
+			int inner = 1 + genRandom(count - i);
+			printf("w%d = 0\n", nest);
+			genIndent(depth);
+			printf("while w%d < 2 do\n", nest);
+			genBlock(opt, func, params, inner, depth + 1, nest + 1);
+			genIndent(depth + 1);
+			printf("w%d = w%d + 1\n", nest, nest);
+			genIndent(depth);
+			printf("end\n");
+			i += inner;
+		}else if(pick < 4 && callable > 0 && nest == 0 && calls > 0){
+			// Volání dříve definované funkce (mimo podmínky a cykly)
+			calls--;
+			printf("v%d = f%d(v%d, %d)\n", genRandom(opt->vars), genRandom(callable), genRandom(opt->vars), genRandom(100));
+		}else if(pick < 6){
+			printf("s%d = ", genRandom(opt->vars));
+			if(genRandom(2) == 0) genString(opt);
+			else printf("s%d + s%d", genRandom(opt->vars), genRandom(opt->vars));
+			putchar('\n');
+		}else if(pick < 7){
+			printf("v%d = length(s%d)\n", genRandom(opt->vars), genRandom(opt->vars));
+		}else{
+			printf("v%d = ", genRandom(opt->vars));
+			genExpr(opt, opt->exprDepth, params);
+			putchar('\n');
+		}
+	}
+}
+
+/**
+ * Inicializace proměnných funkce (všechny proměnné musí být definované před použitím)
+ */
+static void genVars(const tGenOptions *opt, int depth){
+	for(int i = 0; i < opt->vars; i++){
+		genIndent(depth);
+		printf("v%d = %d\n", i, genRandom(100));
+		genIndent(depth);
+		printf("s%d = ", i);
+		genString(opt);
+		putchar('\n');
+	}
+	for(int i = 0; i < opt->nesting; i++){
+		genIndent(depth);
+		printf("w%d = 0\n", i);
+	}
+}
+
+/**
+ * Načte číselný parametr (při chybě ukončí program)
+ */
+static long genNumber(const char *arg, long min){
+	char *end;
+	long value = strtol(arg, &end, 10);
+	if(*end != '\0' || value < min){
+		fprintf(stderr, "Invalid number %s\n", arg);
+		exit(1);
+	}
+	return value;
+}
+
+int main(int argc, char *argv[]){
+	tGenOptions opt = { .functions = 100, .statements = 40, .vars = 8, .exprDepth = 3,
+		.stringSize = 16, .nesting = 3, .comments = 10, .seed = 1 };
+
+	for(int i = 1; i < argc; i++){
+		if(i + 1 >= argc) goto usage;
+		if(strcmp(argv[i], "--functions") == 0) opt.functions = genNumber(argv[++i], 0);
+		else if(strcmp(argv[i], "--statements") == 0) opt.statements = genNumber(argv[++i], 1);
+		else if(strcmp(argv[i], "--vars") == 0) opt.vars = genNumber(argv[++i], 1);
+		else if(strcmp(argv[i], "--expr-depth") == 0) opt.exprDepth = genNumber(argv[++i], 0);
+		else if(strcmp(argv[i], "--string-size") == 0) opt.stringSize = genNumber(argv[++i], 0);
+		else if(strcmp(argv[i], "--nesting") == 0) opt.nesting = genNumber(argv[++i], 0);
+		else if(strcmp(argv[i], "--comments") == 0) opt.comments = genNumber(argv[++i], 0);
+		else if(strcmp(argv[i], "--seed") == 0) opt.seed = genNumber(argv[++i], 0);
+		else goto usage;
+	}
+
+	// xorshift nesmí začít nulou
+	genState = opt.seed * 0x9E3779B97F4A7C15u + 1;
+
+	printf("# Generated by gen-program --functions %d --statements %d --vars %d --expr-depth %d "
+		"--string-size %d --nesting %d --comments %d --seed %llu\n", opt.functions, opt.statements,
+		opt.vars, opt.exprDepth, opt.stringSize, opt.nesting, opt.comments, (unsigned long long)opt.seed);
+
+	for(int f = 0; f < opt.functions; f++){
+		genComment(&opt, 0);
+		printf("def f%d(a, b)\n", f);
+		genVars(&opt, 1);
+		genBlock(&opt, f, 2, opt.statements, 1, 0);
+		printf("\tv0\nend\n\n");
+	}
+
+	genVars(&opt, 0);
+	genBlock(&opt, -1, 0, opt.statements, 0, 0);
+	printf("print(v0, \"\\n\")\n");
+	return 0;
+
+usage:
+	fprintf(stderr, "Usage: %s [--functions n] [--statements n] [--vars n] [--expr-depth n] "
+		"[--string-size n] [--nesting n] [--comments percent] [--seed n] > program.ifj\n", argv[0]);
+	return 1;
+}
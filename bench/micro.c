@@ -0,0 +1,506 @@
+/**
+ * @file micro.c
+ *
+ * Mikrobenchmarky jednotlivých částí překladače - scannerFSM nad různými
+ * druhy lexémů, tabulka symbolů s náhodnými a seřazenými klíči, exprParse
+ * nad hlubokými a širokými výrazy a převody literálů do IFJcode18
+ *
+ * Použití: make micro (případně obj/micro [--repeat n] [--warmup n] [filtr...])
+ *
+ * Každý benchmark se nejdřív --warmup krát zahřeje a pak --repeat krát změří.
+ * Vypíše se medián, 10. a 90. percentil a maximum doby jednoho běhu a medián
+ * na jednu operaci (lexém, vložení, token výrazu, literál). S filtrem se
+ * spustí jen benchmarky, jejichž jméno obsahuje některý z filtrů.
+ *
+ * IFJ Projekt 2018, Tým 13
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include "context.h"
+#include "scanner.h"
+#include "symtable.h"
+#include "expressions.h"
+#include <time.h>
+
+/**
+ * Benchmark - příprava a úklid se neměří
+ */
+typedef struct Micro{
+	const char *name;
+	void (*setup)(void);		//!< Příprava před každým během (NULL = žádná)
+	void (*run)(void);			//!< Měřený běh
+	void (*teardown)(void);		//!< Úklid po každém běhu (NULL = žádný)
+	long *ops;					//!< Počet operací jednoho běhu (nastaví příprava nebo běh)
+} tMicro;
+
+/**
+ * Stav generátoru náhodných čísel (xorshift64, vždy stejná data)
+ */
+static uint64_t microState = 1;
+
+static int microRandom(int max){
+	microState ^= microState << 13;
+	microState ^= microState >> 7;
+	microState ^= microState << 17;
+	return (int)(microState % (uint64_t)max);
+}
+
+static double microClock(){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * Rostoucí buffer pro vstupy benchmarků
+ */
+typedef struct MicroText{
+	char *data;
+	size_t len;
+	size_t size;
+} tMicroText;
+
+static void textAppend(tMicroText *text, const char *format, ...){
+	va_list args;
+	va_start(args, format);
+	char line[256];
+	int len = vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+
+	if(text->len + len + 1 > text->size){
+		text->size = text->size > 0 ? text->size * 2 : 4096;
+		while(text->len + len + 1 > text->size) text->size *= 2;
+		text->data = safeRealloc(text->data, text->size);
+	}
+	memcpy(text->data + text->len, line, len + 1);
+	text->len += len;
+}
+
+/* ---------------------------------------------------------------- scanner */
+
+/**
+ * Přibližná velikost vstupu lexikálního analyzátoru
+ */
+#define MICRO_SCAN_SIZE (256 * 1024)
+
+static tMicroText scanText;
+static FILE *scanFile;
+static long scanOps;
+
+static void scanIds(tMicroText *text){
+	static const char *keywords[] = { "if", "then", "else", "end", "while", "do", "def", "nil" };
+	if(microRandom(5) == 0){
+		textAppend(text, "%s", keywords[microRandom(8)]);
+		return;
+	}
+	int len = 1 + microRandom(12);
+	char id[16];
+	id[0] = 'a' + microRandom(26);
+	for(int i = 1; i < len; i++) id[i] = "abcdefghijklmnopqrstuvwxyz_0123456789ABC"[microRandom(40)];
+	id[len] = '\0';
+	textAppend(text, "%s%s", id, microRandom(10) == 0 ? "?" : "");
+}
+
+static void scanNumbers(tMicroText *text){
+	switch(microRandom(6)){
+		case 0: textAppend(text, "%d", microRandom(1000000)); break;
+		case 1: textAppend(text, "%d.%d", microRandom(1000), microRandom(1000)); break;
+		case 2: textAppend(text, "%d.%de-%d", microRandom(100), microRandom(100), microRandom(20)); break;
+		case 3: textAppend(text, "0x%X", microRandom(65536)); break;
+		case 4: textAppend(text, "0b%d%d%d1", microRandom(2), microRandom(2), microRandom(2)); break;
+		default: textAppend(text, "0%o", 1 + microRandom(4096)); break;
+	}
+}
+
+static void scanStrings(tMicroText *text){
+	char str[128];
+	int len = microRandom(40);
+	int pos = 0;
+	for(int i = 0; i < len; i++){
+		int kind = microRandom(10);
+		if(kind == 0){
+			str[pos++] = '\\';
+			str[pos++] = "ntsx\"\\"[microRandom(6)];
+			if(str[pos - 1] == 'x'){
+				str[pos++] = "0123456789abcdef"[microRandom(16)];
+				str[pos++] = "0123456789abcdef"[microRandom(16)];
+			}
+		}else{
+			str[pos++] = 'a' + microRandom(26);
+		}
+	}
+	str[pos] = '\0';
+	textAppend(text, "\"%s\"", str);
+}
+
+static void scanOperators(tMicroText *text){
+	static const char *ops[] = { "+", "-", "*", "/", "<", "<=", ">", ">=", "==", "!=", "=", "(", ")", "," };
+	textAppend(text, "%s", ops[microRandom(14)]);
+}
+
+static void scanComments(tMicroText *text){
+	if(microRandom(8) == 0) textAppend(text, "\n=begin\nblock comment line\nanother line\n=end");
+	else textAppend(text, "# comment with keywords if then end and \"quotes\" %d", microRandom(1000));
+}
+
+static void scanMixed(tMicroText *text){
+	static void (*kinds[])(tMicroText *) = { scanIds, scanIds, scanIds, scanNumbers, scanStrings, scanOperators, scanOperators };
+	kinds[microRandom(7)](text);
+}
+
+/**
+ * Vstup z lexémů jednoho druhu oddělených mezerami (občas koncem řádku)
+ *
+ * Řádky jsou odsazené jako ve skutečném programu, '=' na začátku řádku by
+ * scanner četl jako začátek blokového komentáře
+ */
+static void scanPrepare(void (*lexeme)(tMicroText *)){
+	free(scanText.data);
+	memset(&scanText, 0, sizeof(scanText));
+	microState = 1;
+	while(scanText.len < MICRO_SCAN_SIZE){
+		lexeme(&scanText);
+		textAppend(&scanText, microRandom(8) == 0 || lexeme == scanComments ? "\n\t" : " ");
+	}
+}
+
+static void scanSetup(){
+	scanFile = fmemopen(scanText.data, scanText.len, "r");
+	if(scanFile == NULL){
+		fprintf(stderr, "fmemopen failed\n");
+		exit(1);
+	}
+	scannerInit();
+}
+
+static void scanRun(){
+	struct Token token;
+	scanOps = 0;
+	do{
+		token.data = NULL;
+		scannerFSM(scanFile, &token);
+		free(token.data);
+		if(token.type != T_UNKNOWN) scanOps++;
+	}while(token.type != T_EOF);
+}
+
+static void scanTeardown(){
+	fclose(scanFile);
+}
+
+static void scanSetupIds(){ if(scanFile == NULL) scanPrepare(scanIds); scanSetup(); }
+static void scanSetupNumbers(){ if(scanFile == NULL) scanPrepare(scanNumbers); scanSetup(); }
+static void scanSetupStrings(){ if(scanFile == NULL) scanPrepare(scanStrings); scanSetup(); }
+static void scanSetupOperators(){ if(scanFile == NULL) scanPrepare(scanOperators); scanSetup(); }
+static void scanSetupComments(){ if(scanFile == NULL) scanPrepare(scanComments); scanSetup(); }
+static void scanSetupMixed(){ if(scanFile == NULL) scanPrepare(scanMixed); scanSetup(); }
+
+/* --------------------------------------------------------------- symtable */
+
+/**
+ * Počet klíčů tabulky symbolů
+ */
+#define MICRO_SYMBOLS 4096
+
+static char symKeys[MICRO_SYMBOLS][16];
+static int symOrder[MICRO_SYMBOLS];		//!< Pořadí vkládání (náhodné nebo seřazené)
+static int symLookup[MICRO_SYMBOLS];	//!< Pořadí vyhledávání (vždy náhodné)
+static psTree symTree;
+static long symOps = MICRO_SYMBOLS;
+static bool symSorted;
+
+static void symShuffle(int *order){
+	for(int i = 0; i < MICRO_SYMBOLS; i++) order[i] = i;
+	for(int i = MICRO_SYMBOLS - 1; i > 0; i--){
+		int j = microRandom(i + 1);
+		int tmp = order[i];
+		order[i] = order[j];
+		order[j] = tmp;
+	}
+}
+
+static void symPrepare(bool sorted){
+	microState = 1;
+	// Klíče jsou seřazené podle indexu (strcmp i číselně)
+	for(int i = 0; i < MICRO_SYMBOLS; i++) sprintf(symKeys[i], "var%05d", i);
+	symShuffle(symOrder);
+	if(sorted) for(int i = 0; i < MICRO_SYMBOLS; i++) symOrder[i] = i;
+	symShuffle(symLookup);
+	symSorted = sorted;
+}
+
+static void symInsertAll(){
+	symTabInit(&symTree);
+	for(int i = 0; i < MICRO_SYMBOLS; i++){
+		psData data = safeMalloc(sizeof(struct sData));
+		data->type = VAR;
+		data->defined = true;
+		data->localFrame = NULL;
+		data->params = 0;
+		symTabInsert(&symTree, symKeys[symOrder[i]], data);
+	}
+}
+
+static void symSearchAll(){
+	for(int i = 0; i < MICRO_SYMBOLS; i++){
+		if(symTabSearch(&symTree, symKeys[symLookup[i]]) == NULL){
+			fprintf(stderr, "symTabSearch lost key %s\n", symKeys[symLookup[i]]);
+			exit(1);
+		}
+	}
+}
+
+static void symDispose(){
+	symTabDispose(&symTree);
+}
+
+static void symSetupRandom(){ symPrepare(false); }
+static void symSetupSorted(){ symPrepare(true); }
+static void symSetupSearchRandom(){ symPrepare(false); symInsertAll(); }
+static void symSetupSearchSorted(){ symPrepare(true); symInsertAll(); }
+
+/* ------------------------------------------------------------ expressions */
+
+/**
+ * Počet zpracování výrazu v jednom běhu
+ */
+#define MICRO_EXPR_PASSES 16
+
+static pToken exprTokens;
+static psTree exprTable;
+static long exprOps;
+static FILE *exprNull;
+
+/**
+ * Rozloží výraz na tokeny a připraví tabulku proměnných a..z
+ */
+static void exprPrepare(const char *source){
+	FILE *file = fmemopen((void *)source, strlen(source), "r");
+	scannerInit();
+	if(file == NULL || scannerGetTokenList(&exprTokens, file) != 0){
+		fprintf(stderr, "Cannot scan expression\n");
+		exit(1);
+	}
+	fclose(file);
+
+	exprOps = 0;
+	for(pToken token = exprTokens; token->type != T_EOF; token = token->nextToken) exprOps++;
+	exprOps *= MICRO_EXPR_PASSES;
+
+	static char names[26][2];
+	symTabInit(&exprTable);
+	for(int i = 0; i < 26; i++){
+		names[i][0] = 'a' + i;
+		psData data = safeMalloc(sizeof(struct sData));
+		data->type = VAR;
+		data->defined = true;
+		data->localFrame = NULL;
+		data->params = 0;
+		symTabInsert(&exprTable, names[i], data);
+	}
+}
+
+static void exprRun(){
+	for(int i = 0; i < MICRO_EXPR_PASSES; i++){
+		pToken token = exprTokens;
+		if(exprParse(&token, exprTable) != 0){
+			fprintf(stderr, "exprParse failed\n");
+			exit(1);
+		}
+	}
+}
+
+static void exprTeardown(){
+	// Výstup se zahazuje, buffer se vypisuje průběžně
+	outFlush();
+}
+
+static void exprDispose(){
+	scannerFreeTokenList(&exprTokens);
+	symTabDispose(&exprTable);
+}
+
+static void exprSetupDeep(){
+	if(exprTokens != NULL) return;
+	// ((((a + 1) * b) - 2) ...) s hloubkou 256
+	tMicroText text = { 0 };
+	microState = 1;
+	for(int i = 0; i < 256; i++) textAppend(&text, "(");
+	textAppend(&text, "a");
+	for(int i = 0; i < 256; i++){
+		static const char *ops[] = { "+", "-", "*" };
+		if(microRandom(2) == 0) textAppend(&text, " %s %d)", ops[microRandom(3)], 1 + microRandom(100));
+		else textAppend(&text, " %s %c)", ops[microRandom(3)], 'a' + microRandom(26));
+	}
+	textAppend(&text, "\n");
+	exprPrepare(text.data);
+	free(text.data);
+}
+
+static void exprSetupWide(){
+	if(exprTokens != NULL) return;
+	// a + b * 3 - c ... se 2048 členy a precedencí
+	tMicroText text = { 0 };
+	microState = 1;
+	textAppend(&text, "a");
+	for(int i = 0; i < 2048; i++){
+		static const char *ops[] = { "+", "-", "*" };
+		if(microRandom(2) == 0) textAppend(&text, " %s %d", ops[microRandom(3)], 1 + microRandom(100));
+		else textAppend(&text, " %s %c", ops[microRandom(3)], 'a' + microRandom(26));
+	}
+	textAppend(&text, "\n");
+	exprPrepare(text.data);
+	free(text.data);
+}
+
+/* ---------------------------------------------------------------- literály */
+
+/**
+ * Počet literálů převedených v jednom běhu
+ */
+#define MICRO_LITERALS 4096
+
+static char *literals[MICRO_LITERALS];
+static char *(*literalConvert)(char *);
+static long literalOps = MICRO_LITERALS;
+
+static void literalPrepare(void (*lexeme)(tMicroText *), char *(*convert)(char *)){
+	if(literalConvert == convert) return;
+	for(int i = 0; i < MICRO_LITERALS; i++) free(literals[i]);
+
+	microState = 1;
+	for(int i = 0; i < MICRO_LITERALS; i++){
+		tMicroText text = { 0 };
+		lexeme(&text);
+		literals[i] = text.data;
+	}
+	literalConvert = convert;
+}
+
+static void literalRun(){
+	for(int i = 0; i < MICRO_LITERALS; i++) free(literalConvert(literals[i]));
+}
+
+static void intLexeme(tMicroText *text){
+	switch(microRandom(4)){
+		case 0: textAppend(text, "%d", microRandom(1000000)); break;
+		case 1: textAppend(text, "0x%X", microRandom(65536)); break;
+		case 2: textAppend(text, "0b%d%d%d1", microRandom(2), microRandom(2), microRandom(2)); break;
+		default: textAppend(text, "0%o", 1 + microRandom(4096)); break;
+	}
+}
+
+static void floatLexeme(tMicroText *text){
+	if(microRandom(2) == 0) textAppend(text, "%d.%d", microRandom(1000), microRandom(1000));
+	else textAppend(text, "%d.%de%d", microRandom(100), microRandom(100), microRandom(20));
+}
+
+static void literalSetupString(){ literalPrepare(scanStrings, stringToInterpret); }
+static void literalSetupInt(){ literalPrepare(intLexeme, intToInterpret); }
+static void literalSetupFloat(){ literalPrepare(floatLexeme, floatToInterpret); }
+
+/* ---------------------------------------------------------------- měření */
+
+static int compareDoubles(const void *a, const void *b){
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return x < y ? -1 : x > y;
+}
+
+static double percentile(const double *sorted, int count, double q){
+	return sorted[(int)(q * (count - 1) + 0.5)];
+}
+
+/**
+ * Spustí benchmark a vypíše řádek výsledků
+ */
+static void microMeasure(const tMicro *micro, int warmup, int repeat){
+	double *times = safeMalloc(repeat * sizeof(double));
+
+	for(int i = -warmup; i < repeat; i++){
+		if(micro->setup != NULL) micro->setup();
+		double start = microClock();
+		micro->run();
+		double time = microClock() - start;
+		if(micro->teardown != NULL) micro->teardown();
+		if(i >= 0) times[i] = time;
+	}
+
+	qsort(times, repeat, sizeof(double), compareDoubles);
+	double median = percentile(times, repeat, 0.5);
+	printf("%-26s %9ld %10.3f %10.3f %10.3f %10.3f %9.1f\n", micro->name, *micro->ops, median * 1e3,
+		percentile(times, repeat, 0.1) * 1e3, percentile(times, repeat, 0.9) * 1e3, times[repeat - 1] * 1e3,
+		median * 1e9 / *micro->ops);
+	free(times);
+}
+
+int main(int argc, char *argv[]){
+	int repeat = 21;
+	int warmup = 3;
+	const char **filters = safeMalloc(argc * sizeof(char *));
+	int filterCount = 0;
+
+	for(int i = 1; i < argc; i++){
+		if(strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) repeat = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) warmup = atoi(argv[++i]);
+		else filters[filterCount++] = argv[i];
+	}
+	if(repeat < 1 || warmup < 0){
+		fprintf(stderr, "Usage: %s [--repeat n] [--warmup n] [filter...]\n", argv[0]);
+		return 1;
+	}
+
+	// Funkce překladače pracují s kontextem, výstup kódu se zahazuje
+	ctx = ifj18_create(NULL);
+	ifj18_set_errors(ctx, stderr);
+	exprNull = fopen("/dev/null", "w");
+	outInit(exprNull);
+	codeInit();
+
+	/*
+	 * Benchmarky stejné skupiny sdílí připravená data, skupina se proto
+	 * připraví při prvním běhu a uvolní až po posledním benchmarku skupiny
+	 */
+	const tMicro micros[] = {
+		{ "scanner/identifiers", scanSetupIds, scanRun, scanTeardown, &scanOps },
+		{ "scanner/numbers", scanSetupNumbers, scanRun, scanTeardown, &scanOps },
+		{ "scanner/strings", scanSetupStrings, scanRun, scanTeardown, &scanOps },
+		{ "scanner/operators", scanSetupOperators, scanRun, scanTeardown, &scanOps },
+		{ "scanner/comments", scanSetupComments, scanRun, scanTeardown, &scanOps },
+		{ "scanner/mixed", scanSetupMixed, scanRun, scanTeardown, &scanOps },
+		{ "symtable/insert-random", symSetupRandom, symInsertAll, symDispose, &symOps },
+		{ "symtable/insert-sorted", symSetupSorted, symInsertAll, symDispose, &symOps },
+		{ "symtable/search-random", symSetupSearchRandom, symSearchAll, symDispose, &symOps },
+		{ "symtable/search-sorted", symSetupSearchSorted, symSearchAll, symDispose, &symOps },
+		{ "expr/deep", exprSetupDeep, exprRun, exprTeardown, &exprOps },
+		{ "expr/wide", exprSetupWide, exprRun, exprTeardown, &exprOps },
+		{ "literal/string", literalSetupString, literalRun, NULL, &literalOps },
+		{ "literal/int", literalSetupInt, literalRun, NULL, &literalOps },
+		{ "literal/float", literalSetupFloat, literalRun, NULL, &literalOps },
+	};
+
+	printf("%-26s %9s %10s %10s %10s %10s %9s\n", "benchmark", "ops", "median ms", "p10 ms", "p90 ms", "max ms", "ns/op");
+	for(size_t i = 0; i < sizeof(micros) / sizeof(micros[0]); i++){
+		bool selected = filterCount == 0;
+		for(int f = 0; f < filterCount; f++)
+			if(strstr(micros[i].name, filters[f]) != NULL) selected = true;
+		if(selected) microMeasure(&micros[i], warmup, repeat);
+
+		// Uvolnění dat skupiny (další benchmark je připraví znovu)
+		if(micros[i].run == scanRun){
+			free(scanText.data);
+			memset(&scanText, 0, sizeof(scanText));
+			scanFile = NULL;
+		}else if(micros[i].run == exprRun && exprTokens != NULL){
+			exprDispose();
+		}
+	}
+
+	for(int i = 0; i < MICRO_LITERALS; i++) free(literals[i]);
+	codeDispose();
+	outDispose();
+	fclose(exprNull);
+	ifj18_destroy(ctx);
+	free(filters);
+	return 0;
+}
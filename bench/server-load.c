@@ -0,0 +1,177 @@
+/**
+ * @file server-load.c
+ *
+ * Zátěžový klient překladového serveru - posílá stále stejný program
+ * a měří dobu odpovědi (p50, p99)
+ *
+ * Použití: obj/server-load socket soubor [počet]
+ *          obj/server-load --exec překladač soubor [počet]
+ *
+ * S --exec se pro srovnání spouští pro každý požadavek nový proces překladače.
+ *
+ * IFJ Projekt 2018, Tým 13
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+static bool readAll(int fd, void *data, size_t len){
+	char *pos = data;
+	while(len > 0){
+		ssize_t got = read(fd, pos, len);
+		if(got <= 0) return false;
+		pos += got;
+		len -= got;
+	}
+	return true;
+}
+
+static bool writeAll(int fd, const void *data, size_t len){
+	const char *pos = data;
+	while(len > 0){
+		ssize_t put = write(fd, pos, len);
+		if(put <= 0) return false;
+		pos += put;
+		len -= put;
+	}
+	return true;
+}
+
+static bool readU32(int fd, uint32_t *value){
+	unsigned char b[4];
+	if(!readAll(fd, b, 4)) return false;
+	*value = (uint32_t)b[0] << 24 | b[1] << 16 | b[2] << 8 | b[3];
+	return true;
+}
+
+/**
+ * Přeskočí blok odpovědi s délkou
+ */
+static bool skipBlock(int fd){
+	static char buffer[65536];
+	uint32_t len;
+	if(!readU32(fd, &len)) return false;
+	while(len > 0){
+		size_t part = len < sizeof(buffer) ? len : sizeof(buffer);
+		if(!readAll(fd, buffer, part)) return false;
+		len -= part;
+	}
+	return true;
+}
+
+/**
+ * Jeden požadavek na server, vrací návratový kód překladu (-1 při chybě spojení)
+ */
+static int requestServer(int fd, const char *source, uint32_t len){
+	unsigned char header[4] = { len >> 24, len >> 16, len >> 8, len };
+	uint32_t retval;
+	if(!writeAll(fd, header, 4) || !writeAll(fd, source, len)) return -1;
+	if(!readU32(fd, &retval) || !skipBlock(fd) || !skipBlock(fd)) return -1;
+	return retval;
+}
+
+/**
+ * Jeden překlad v novém procesu, vrací návratový kód překladače
+ */
+static int requestExec(const char *compiler, const char *path){
+	pid_t pid = fork();
+	if(pid == 0){
+		int in = open(path, O_RDONLY);
+		int null = open("/dev/null", O_WRONLY);
+		dup2(in, STDIN_FILENO);
+		dup2(null, STDOUT_FILENO);
+		dup2(null, STDERR_FILENO);
+		execl(compiler, compiler, (char *)NULL);
+		_exit(127);
+	}
+
+	int status;
+	if(pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) return -1;
+	return WEXITSTATUS(status);
+}
+
+static int compareTimes(const void *a, const void *b){
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
+int main(int argc, char *argv[]){
+	bool exec = argc > 1 && strcmp(argv[1], "--exec") == 0;
+	if(argc < 3 + exec){
+		fprintf(stderr, "Usage: %s socket file [count]\n       %s --exec compiler file [count]\n", argv[0], argv[0]);
+		return 1;
+	}
+	const char *target = argv[1 + exec];
+	const char *path = argv[2 + exec];
+	int count = argc > 3 + exec ? atoi(argv[3 + exec]) : 1000;
+	if(count < 1) count = 1;
+
+	FILE *file = fopen(path, "rb");
+	if(file == NULL){
+		fprintf(stderr, "Cannot open %s\n", path);
+		return 1;
+	}
+	fseek(file, 0, SEEK_END);
+	long len = ftell(file);
+	rewind(file);
+	char *source = malloc(len > 0 ? len : 1);
+	if(source == NULL || fread(source, 1, len, file) != (size_t)len){
+		fprintf(stderr, "Cannot read %s\n", path);
+		return 1;
+	}
+	fclose(file);
+
+	int fd = -1;
+	if(!exec){
+		struct sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, target, sizeof(addr.sun_path) - 1);
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if(fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0){
+			fprintf(stderr, "Cannot connect to %s\n", target);
+			return 1;
+		}
+	}
+
+	double *times = malloc(count * sizeof(double));
+	int first = -2;
+	for(int i = 0; i < count; i++){
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		int retval = exec ? requestExec(target, path) : requestServer(fd, source, len);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		if(retval < 0 || (first != -2 && retval != first)){
+			fprintf(stderr, "Request %d failed (exit code %d)\n", i, retval);
+			return 1;
+		}
+		first = retval;
+		times[i] = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+	}
+
+	double total = 0;
+	for(int i = 0; i < count; i++)
+		total += times[i];
+	qsort(times, count, sizeof(double), compareTimes);
+
+	printf("%-7s %6d requests, exit %d: p50 %8.1f us, p99 %8.1f us, mean %8.1f us\n",
+		exec ? "exec" : "server", count, first,
+		times[count / 2], times[(int)(count * 0.99) < count ? (int)(count * 0.99) : count - 1], total / count);
+
+	if(fd >= 0) close(fd);
+	free(times);
+	free(source);
+	return 0;
+}
@@ -0,0 +1,26 @@
+#!/bin/sh
+# Benchmark prekladoveho serveru: doba odpovedi serveru proti novemu procesu
+# prekladace pro kazdy preklad
+#
+# Pouziti: bench/server.sh [soubor] [pocet]
+#   soubor     prekladany program (vychozi tests/test-code.1)
+#   pocet      pocet prekladu (vychozi 2000)
+#   COMPILER   cesta k prekladaci (vychozi ./compiler)
+
+cd "$(dirname "$0")/.." || exit 1
+
+COMPILER=${COMPILER:-./compiler}
+SOURCE=${1:-tests/test-code.1}
+COUNT=${2:-2000}
+
+make -s server-load || exit 1
+
+TMP=$(mktemp -d) || exit 1
+$COMPILER --server-socket "$TMP/server.sock" &
+SERVER=$!
+trap 'kill $SERVER; rm -rf "$TMP"' EXIT
+
+while [ ! -S "$TMP/server.sock" ]; do sleep 0.01; done
+
+obj/server-load "$TMP/server.sock" "$SOURCE" "$COUNT" || exit 1
+obj/server-load --exec "$COMPILER" "$SOURCE" "$COUNT" || exit 1
@@ -0,0 +1,29 @@
+#!/bin/sh
+# Benchmark vestavene funkce substr nad retezcem o delce 64 KB
+#
+# Pouziti: bench/substr.sh [interpret]
+#   interpret  cesta k interpretu IFJcode18 (vychozi $IC18INT, jinak ic18int)
+#   COMPILER   cesta k prekladaci (vychozi ./compiler)
+
+cd "$(dirname "$0")/.." || exit 1
+
+COMPILER=${COMPILER:-./compiler}
+INTERPRET=${1:-${IC18INT:-ic18int}}
+CHARS=98310	# pocet znaku zkopirovanych funkci substr v bench/substr.ifj
+
+TMP=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMP"' EXIT
+
+$COMPILER < bench/substr.ifj > "$TMP/substr.code" || exit 1
+
+START=$(date +%s%N)
+$INTERPRET "$TMP/substr.code" > "$TMP/substr.res" < /dev/null
+END=$(date +%s%N)
+
+if ! cmp -s "$TMP/substr.res" bench/substr.out; then
+	echo "substr: chybny vystup" >&2
+	exit 1
+fi
+
+awk -v chars=$CHARS -v ns=$((END - START)) \
+	'BEGIN { printf "substr %8.3f s %12.0f znaku/s\n", ns / 1e9, chars / (ns / 1e9) }'
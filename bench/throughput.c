@@ -0,0 +1,129 @@
+/**
+ * @file throughput.c
+ *
+ * Měření propustnosti překladače nad velkými programy - pro každý soubor
+ * vypíše nejkratší dobu překladu, MB/s, tokeny/s a nejvyšší RSS procesu
+ *
+ * Použití: obj/throughput [--repeat n] překladač soubor...
+ *
+ * Překladač se spouští jako nový proces bez přepínačů, počet tokenů se
+ * zjistí jedním překladem navíc s --time-phases=json.
+ *
+ * IFJ Projekt 2018, Tým 13
+ */
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+/**
+ * Spustí překladač se vstupem ze souboru, výstup se zahodí
+ *
+ * @param option Přepínač překladače (NULL = bez přepínačů)
+ * @param errors Deskriptor pro chybový výstup (-1 = zahodit)
+ * @param seconds Uloží dobu překladu
+ * @param rss Uloží nejvyšší RSS procesu v KB
+ * @return int Návratový kód překladače (-1 = nepodařilo se spustit)
+ */
+static int runCompiler(const char *compiler, const char *option, const char *path, int errors, double *seconds, long *rss){
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	pid_t pid = fork();
+	if(pid == 0){
+		int in = open(path, O_RDONLY);
+		int null = open("/dev/null", O_WRONLY);
+		dup2(in, STDIN_FILENO);
+		dup2(null, STDOUT_FILENO);
+		dup2(errors >= 0 ? errors : null, STDERR_FILENO);
+		execl(compiler, compiler, option, (char *)NULL);
+		_exit(127);
+	}
+
+	int status;
+	struct rusage usage;
+	if(pid < 0 || wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status)) return -1;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	*seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	*rss = usage.ru_maxrss;
+	return WEXITSTATUS(status);
+}
+
+/**
+ * Zjistí počet tokenů programu z výpisu --time-phases=json
+ *
+ * @return long Počet tokenů (-1 = nepodařilo se zjistit)
+ */
+static long countTokens(const char *compiler, const char *path){
+	FILE *errors = tmpfile();
+	if(errors == NULL) return -1;
+
+	double seconds;
+	long rss;
+	long tokens = -1;
+	if(runCompiler(compiler, "--time-phases=json", path, fileno(errors), &seconds, &rss) == 0){
+		char line[4096];
+		rewind(errors);
+		while(fgets(line, sizeof(line), errors) != NULL){
+			char *pos = strstr(line, "\"tokens\":");
+			if(pos != NULL) tokens = strtol(pos + strlen("\"tokens\":"), NULL, 10);
+		}
+	}
+
+	fclose(errors);
+	return tokens;
+}
+
+int main(int argc, char *argv[]){
+	int repeat = 3;
+	int first = 1;
+	if(argc > 2 && strcmp(argv[1], "--repeat") == 0){
+		repeat = atoi(argv[2]);
+		first = 3;
+	}
+	if(argc < first + 2 || repeat < 1){
+		fprintf(stderr, "Usage: %s [--repeat n] compiler file...\n", argv[0]);
+		return 1;
+	}
+	const char *compiler = argv[first];
+
+	printf("%-24s %9s %10s %9s %8s %12s %10s\n", "file", "size MB", "tokens", "best s", "MB/s", "tokens/s", "RSS MB");
+	for(int i = first + 1; i < argc; i++){
+		const char *path = argv[i];
+		struct stat st;
+		if(stat(path, &st) != 0){
+			fprintf(stderr, "Cannot read %s\n", path);
+			return 1;
+		}
+
+		double best = 0;
+		long peak = 0;
+		for(int r = 0; r < repeat; r++){
+			double seconds;
+			long rss;
+			int retval = runCompiler(compiler, NULL, path, -1, &seconds, &rss);
+			if(retval != 0){
+				fprintf(stderr, "%s: compiler returned %d\n", path, retval);
+				return 1;
+			}
+			if(r == 0 || seconds < best) best = seconds;
+			if(rss > peak) peak = rss;
+		}
+
+		long tokens = countTokens(compiler, path);
+		const char *name = strrchr(path, '/');
+		double mb = st.st_size / 1e6;
+		printf("%-24s %9.2f %10ld %9.3f %8.2f %12.0f %10.1f\n", name != NULL ? name + 1 : path,
+			mb, tokens, best, mb / best, tokens / best, peak / 1024.0);
+	}
+	return 0;
+}
@@ -0,0 +1,28 @@
+#!/bin/sh
+# Benchmark propustnosti prekladace nad generovanymi programy (make bench):
+# MB/s, tokeny/s a nejvyssi RSS pro programy ruzne velikosti a skladby
+#
+# Pouziti: bench/throughput.sh [opakovani]
+#   opakovani  pocet prekladu kazdeho programu, vypise se nejkratsi (vychozi 3)
+#   COMPILER   cesta k prekladaci (vychozi ./compiler)
+
+cd "$(dirname "$0")/.." || exit 1
+
+COMPILER=${COMPILER:-./compiler}
+REPEAT=${1:-3}
+
+make -s gen-program throughput || exit 1
+
+TMP=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMP"' EXIT
+
+# Programy jsou deterministicke (vychozi --seed 1), vysledky jsou tak porovnatelne mezi behy
+obj/gen-program --functions 50 > "$TMP/small.ifj" || exit 1
+obj/gen-program --functions 500 > "$TMP/medium.ifj" || exit 1
+obj/gen-program --functions 3000 > "$TMP/large.ifj" || exit 1
+obj/gen-program --functions 300 --string-size 400 > "$TMP/strings.ifj" || exit 1
+obj/gen-program --functions 300 --expr-depth 7 --nesting 6 > "$TMP/deep.ifj" || exit 1
+obj/gen-program --functions 500 --comments 60 > "$TMP/comments.ifj" || exit 1
+
+obj/throughput --repeat "$REPEAT" "$COMPILER" "$TMP/small.ifj" "$TMP/medium.ifj" "$TMP/large.ifj" \
+	"$TMP/strings.ifj" "$TMP/deep.ifj" "$TMP/comments.ifj"
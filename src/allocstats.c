@@ -0,0 +1,308 @@
+/**
+ * @file allocstats.c
+ * 
+ * Statistika alokací podle místa volání (sestavení přes make ALLOC_STATS=1)
+ * 
+ * IFJ Projekt 2018, Tým 13
+ * 
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+// Bez common.h - tady se volají skutečné malloc, realloc a free
+#include "allocstats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/**
+ * Počty alokací jednoho místa volání nebo modulu
+ */
+typedef struct AllocCounts{
+	unsigned long allocs;		//!< Počet alokací
+	unsigned long reallocs;		//!< Počet realokací
+	size_t bytes;				//!< Celkem alokované bajty (u realokace nová velikost)
+	size_t live;				//!< Právě alokované bajty
+	size_t peak;				//!< Nejvíc najednou alokovaných bajtů
+} tAllocCounts;
+
+/**
+ * Místo volání
+ */
+typedef struct AllocSite{
+	const char *file;			//!< Zdrojový soubor (NULL = volné místo v tabulce)
+	int line;					//!< Řádek
+	int tag;					//!< Index modulu
+	tAllocCounts counts;
+} tAllocSite;
+
+/**
+ * Modul (zdrojový soubor bez cesty a přípony)
+ */
+typedef struct AllocTag{
+	char name[32];
+	tAllocCounts counts;
+} tAllocTag;
+
+/**
+ * Alokovaný blok
+ */
+typedef struct AllocBlock{
+	void *ptr;					//!< Ukazatel na blok (NULL = volné místo v tabulce)
+	size_t size;				//!< Velikost bloku
+	tAllocSite *site;			//!< Místo poslední alokace nebo realokace
+} tAllocBlock;
+
+/**
+ * Stav statistiky (společný pro všechna vlákna)
+ */
+static struct{
+	pthread_mutex_t lock;
+	bool registered;			//!< Výpis je zaregistrovaný přes atexit
+	tAllocSite sites[ALLOC_STATS_SITES];	//!< Místa volání (rozptylová tabulka)
+	int siteCount;
+	tAllocTag tags[ALLOC_STATS_TAGS];
+	int tagCount;
+	tAllocBlock *blocks;		//!< Alokované bloky (rozptylová tabulka s lineárním zkoušením)
+	size_t blocksSize;
+	size_t blockCount;
+	tAllocCounts total;
+} allocStats = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+/**
+ * Ukončí program po neúspěšné alokaci (stejně jako safeMalloc)
+ */
+static void allocStatsFail(){
+	pthread_mutex_unlock(&allocStats.lock);
+	fprintf(stderr, "[INTERNAL] Fatal error - cannot allocate memory\n");
+	exit(99);
+}
+
+/**
+ * Přičte alokaci k počtům
+ */
+static void allocStatsCount(tAllocCounts *counts, bool realloc, size_t size){
+	if(realloc) counts->reallocs++;
+	else counts->allocs++;
+	counts->bytes += size;
+	counts->live += size;
+	if(counts->live > counts->peak) counts->peak = counts->live;
+}
+
+/**
+ * Odečte uvolněné bajty od počtů
+ */
+static void allocStatsUncount(tAllocCounts *counts, size_t freed){
+	counts->live -= freed;
+}
+
+/**
+ * Najde (nebo založí) modul podle jména zdrojového souboru
+ */
+static int allocStatsTag(const char *file){
+	const char *name = strrchr(file, '/');
+	name = name != NULL ? name + 1 : file;
+	size_t len = strcspn(name, ".");
+	if(len >= sizeof(allocStats.tags[0].name)) len = sizeof(allocStats.tags[0].name) - 1;
+
+	for(int i = 0; i < allocStats.tagCount; i++)
+		if(strncmp(allocStats.tags[i].name, name, len) == 0 && allocStats.tags[i].name[len] == '\0') return i;
+
+	// Přeplnění nastane jen při víc než ALLOC_STATS_TAGS zdrojových souborech, počítá se k poslednímu
+	if(allocStats.tagCount == ALLOC_STATS_TAGS) return ALLOC_STATS_TAGS - 1;
+	tAllocTag *tag = &allocStats.tags[allocStats.tagCount];
+	memcpy(tag->name, name, len);
+	tag->name[len] = '\0';
+	return allocStats.tagCount++;
+}
+
+/**
+ * Najde (nebo založí) místo volání
+ */
+static tAllocSite *allocStatsSite(const char *file, int line){
+	// __FILE__ je v jednom modulu vždy stejný literál, stačí porovnat ukazatel
+	size_t index = ((uintptr_t)file * 31 + line) % ALLOC_STATS_SITES;
+	while(allocStats.sites[index].file != NULL){
+		tAllocSite *site = &allocStats.sites[index];
+		if(site->line == line && (site->file == file || strcmp(site->file, file) == 0)) return site;
+		index = (index + 1) % ALLOC_STATS_SITES;
+	}
+
+	if(allocStats.siteCount == ALLOC_STATS_SITES - 1) allocStatsFail();
+	tAllocSite *site = &allocStats.sites[index];
+	site->file = file;
+	site->line = line;
+	site->tag = allocStatsTag(file);
+	allocStats.siteCount++;
+	return site;
+}
+
+/**
+ * Index bloku v tabulce bloků
+ */
+static size_t allocStatsBlockIndex(void *ptr){
+	uint64_t hash = (uintptr_t)ptr * 0x9E3779B97F4A7C15u;
+	return (size_t)(hash >> 32) & (allocStats.blocksSize - 1);
+}
+
+/**
+ * Najde blok v tabulce bloků
+ * 
+ * @return tAllocBlock* Blok, NULL = blok nebyl alokovaný přes safeMalloc
+ */
+static tAllocBlock *allocStatsFind(void *ptr){
+	if(allocStats.blocksSize == 0) return NULL;
+	for(size_t i = allocStatsBlockIndex(ptr); allocStats.blocks[i].ptr != NULL; i = (i + 1) & (allocStats.blocksSize - 1))
+		if(allocStats.blocks[i].ptr == ptr) return &allocStats.blocks[i];
+	return NULL;
+}
+
+/**
+ * Vloží blok do tabulky bloků (při zaplnění z poloviny ji zvětší)
+ */
+static void allocStatsInsert(void *ptr, size_t size, tAllocSite *site){
+	if(2 * (allocStats.blockCount + 1) > allocStats.blocksSize){
+		tAllocBlock *old = allocStats.blocks;
+		size_t oldSize = allocStats.blocksSize;
+		allocStats.blocksSize = oldSize > 0 ? oldSize * 2 : ALLOC_STATS_BLOCKS;
+		allocStats.blocks = calloc(allocStats.blocksSize, sizeof(tAllocBlock));
+		if(allocStats.blocks == NULL) allocStatsFail();
+
+		allocStats.blockCount = 0;
+		for(size_t i = 0; i < oldSize; i++)
+			if(old[i].ptr != NULL) allocStatsInsert(old[i].ptr, old[i].size, old[i].site);
+		free(old);
+	}
+
+	size_t i = allocStatsBlockIndex(ptr);
+	while(allocStats.blocks[i].ptr != NULL) i = (i + 1) & (allocStats.blocksSize - 1);
+	allocStats.blocks[i] = (tAllocBlock){ .ptr = ptr, .size = size, .site = site };
+	allocStats.blockCount++;
+}
+
+/**
+ * Odstraní blok z tabulky bloků (následující bloky se posunou, aby je šlo dál najít)
+ */
+static void allocStatsRemove(tAllocBlock *block){
+	size_t mask = allocStats.blocksSize - 1;
+	size_t hole = block - allocStats.blocks;
+	allocStats.blocks[hole].ptr = NULL;
+	allocStats.blockCount--;
+
+	for(size_t i = (hole + 1) & mask; allocStats.blocks[i].ptr != NULL; i = (i + 1) & mask){
+		size_t home = allocStatsBlockIndex(allocStats.blocks[i].ptr);
+		// Blok může na místo díry, pokud jeho domovský index neleží mezi dírou a ním
+		if(((i - home) & mask) >= ((i - hole) & mask)){
+			allocStats.blocks[hole] = allocStats.blocks[i];
+			allocStats.blocks[i].ptr = NULL;
+			hole = i;
+		}
+	}
+}
+
+/**
+ * Zaznamená uvolnění bloku (jen u bloků alokovaných přes safeMalloc)
+ */
+static void allocStatsForget(void *ptr){
+	tAllocBlock *block = allocStatsFind(ptr);
+	if(block == NULL) return;
+
+	allocStatsUncount(&block->site->counts, block->size);
+	allocStatsUncount(&allocStats.tags[block->site->tag].counts, block->size);
+	allocStatsUncount(&allocStats.total, block->size);
+	allocStatsRemove(block);
+}
+
+/**
+ * Zaznamená alokaci nebo realokaci bloku
+ */
+static void allocStatsRecord(void *ptr, size_t size, const char *file, int line, bool realloc){
+	if(!allocStats.registered){
+		allocStats.registered = true;
+		atexit(allocStatsReport);
+	}
+
+	tAllocSite *site = allocStatsSite(file, line);
+	allocStatsCount(&site->counts, realloc, size);
+	allocStatsCount(&allocStats.tags[site->tag].counts, realloc, size);
+	allocStatsCount(&allocStats.total, realloc, size);
+	allocStatsInsert(ptr, size, site);
+}
+
+void *allocStatsMalloc(size_t size, const char *file, int line){
+	void *ret = malloc(size);
+	pthread_mutex_lock(&allocStats.lock);
+	if(ret == NULL) allocStatsFail();
+	allocStatsRecord(ret, size, file, line, false);
+	pthread_mutex_unlock(&allocStats.lock);
+	return ret;
+}
+
+void *allocStatsRealloc(void *block, size_t size, const char *file, int line){
+	// Původní blok se musí zapomenout dřív, než ho realloc uvolní (adresu pak může dostat jiné vlákno)
+	pthread_mutex_lock(&allocStats.lock);
+	if(block != NULL) allocStatsForget(block);
+	void *ret = realloc(block, size);
+	if(ret == NULL) allocStatsFail();
+	allocStatsRecord(ret, size, file, line, block != NULL);
+	pthread_mutex_unlock(&allocStats.lock);
+	return ret;
+}
+
+void allocStatsFree(void *block){
+	if(block == NULL) return;
+	pthread_mutex_lock(&allocStats.lock);
+	allocStatsForget(block);
+	free(block);
+	pthread_mutex_unlock(&allocStats.lock);
+}
+
+/**
+ * Porovnání míst volání pro řazení (nejvíc alokovaných bajtů první)
+ */
+static int allocStatsCompare(const void *a, const void *b){
+	const tAllocSite *x = *(const tAllocSite * const *)a;
+	const tAllocSite *y = *(const tAllocSite * const *)b;
+	if(x->counts.bytes != y->counts.bytes) return x->counts.bytes < y->counts.bytes ? 1 : -1;
+	if(x->counts.allocs != y->counts.allocs) return x->counts.allocs < y->counts.allocs ? 1 : -1;
+	return x->line - y->line;
+}
+
+/**
+ * Vypíše jeden řádek souhrnu
+ */
+static void allocStatsLine(const char *name, const tAllocCounts *counts){
+	fprintf(stderr, "[ALLOC] %-28s %10lu %10lu %14zu %12zu\n", name, counts->allocs, counts->reallocs, counts->bytes, counts->peak);
+}
+
+void allocStatsReport(){
+	pthread_mutex_lock(&allocStats.lock);
+
+	tAllocSite *sites[ALLOC_STATS_SITES];
+	int count = 0;
+	for(int i = 0; i < ALLOC_STATS_SITES; i++)
+		if(allocStats.sites[i].file != NULL) sites[count++] = &allocStats.sites[i];
+	qsort(sites, count, sizeof(tAllocSite *), allocStatsCompare);
+
+	fprintf(stderr, "[ALLOC] %-28s %10s %10s %14s %12s\n", "site", "allocs", "reallocs", "bytes", "peak live");
+	for(int i = 0; i < count; i++){
+		char name[64];
+		const char *file = strrchr(sites[i]->file, '/');
+		snprintf(name, sizeof(name), "%s:%d", file != NULL ? file + 1 : sites[i]->file, sites[i]->line);
+		allocStatsLine(name, &sites[i]->counts);
+	}
+	for(int i = 0; i < allocStats.tagCount; i++){
+		char name[64];
+		snprintf(name, sizeof(name), "[%s]", allocStats.tags[i].name);
+		allocStatsLine(name, &allocStats.tags[i].counts);
+	}
+	allocStatsLine("total", &allocStats.total);
+	fprintf(stderr, "[ALLOC] %zu bytes in %zu blocks not freed\n", allocStats.total.live, allocStats.blockCount);
+
+	pthread_mutex_unlock(&allocStats.lock);
+}
@@ -0,0 +1,70 @@
+/**
+ * @file allocstats.h
+ * 
+ * Statistika alokací podle místa volání (sestavení přes make ALLOC_STATS=1)
+ * 
+ * V takovém sestavení common.h přesměruje safeMalloc, safeRealloc a free na
+ * funkce tohoto modulu. Ty si pamatují velikost a místo alokace každého bloku,
+ * souhrn (počet alokací a realokací, alokované bajty a nejvíc najednou
+ * alokovaných bajtů) podle místa volání a podle modulu se vypíše na konci
+ * programu na stderr. Uvolnění bloků alokovaných jinde (např. open_memstream)
+ * se ignoruje.
+ * 
+ * IFJ Projekt 2018, Tým 13
+ * 
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+#pragma once
+#include <stddef.h>
+
+/**
+ * Nejvyšší počet různých míst volání
+ */
+#define ALLOC_STATS_SITES 1024
+
+/**
+ * Nejvyšší počet modulů (zdrojových souborů)
+ */
+#define ALLOC_STATS_TAGS 64
+
+/**
+ * Počáteční velikost tabulky alokovaných bloků (při zaplnění z poloviny se zdvojnásobí)
+ */
+#define ALLOC_STATS_BLOCKS 4096
+
+/**
+ * safeMalloc se zaznamenáním alokace
+ * 
+ * @param size Velikost místa pro alokaci
+ * @param file Zdrojový soubor místa volání
+ * @param line Řádek místa volání
+ * @return void* Ukazatel na alokované místo
+ */
+void *allocStatsMalloc(size_t size, const char *file, int line);
+
+/**
+ * safeRealloc se zaznamenáním realokace (blok se přiřadí místu realokace)
+ * 
+ * @param block Ukazatel na alokované místo (NULL = nová alokace)
+ * @param size Velikost nového místa
+ * @param file Zdrojový soubor místa volání
+ * @param line Řádek místa volání
+ * @return void* Ukazatel na nově alokované místo
+ */
+void *allocStatsRealloc(void *block, size_t size, const char *file, int line);
+
+/**
+ * free se zaznamenáním uvolnění
+ * 
+ * @param block Ukazatel na uvolňované místo
+ */
+void allocStatsFree(void *block);
+
+/**
+ * Vypíše souhrn alokací na stderr (volá se automaticky na konci programu)
+ */
+void allocStatsReport();
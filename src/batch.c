@@ -0,0 +1,287 @@
+/**
+ * @file batch.c
+ * 
+ * Dávkový překlad mnoha souborů v jednom procesu
+ * 
+ * IFJ Projekt 2018, Tým 13
+ * 
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+// open_memstream(), getline() a sysconf() jsou součástí POSIX
+#define _POSIX_C_SOURCE 200809L
+#include "batch.h"
+#include "common.h"
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Fronta souborů sdílená vlákny dávky
+ */
+typedef struct BatchQueue{
+	const tOptions *options;	//!< Nastavení překladače
+	const char *outDir;			//!< Složka pro výstupy
+	tBatchFile **order;			//!< Soubory v pořadí zpracování
+	int count;					//!< Počet souborů
+	int next;					//!< Index dalšího souboru ke zpracování
+	pthread_mutex_t lock;		//!< Zámek indexu next
+} tBatchQueue;
+
+/**
+ * Vrátí jméno souboru bez cesty
+ */
+static const char *batchBaseName(const char *path){
+	const char *slash = strrchr(path, '/');
+	return slash != NULL ? slash + 1 : path;
+}
+
+/**
+ * Sestaví cestu k výstupu <outDir>/<jméno><ext>
+ * 
+ * @return char* Cesta (je nutné uvolnit přes free())
+ */
+static char *batchOutPath(const char *outDir, const char *path, const char *ext){
+	const char *name = batchBaseName(path);
+	char *out = safeMalloc(strlen(outDir) + strlen(name) + strlen(ext) + 2);
+	sprintf(out, "%s/%s%s", outDir, name, ext);
+	return out;
+}
+
+/**
+ * Přidá soubor do pole souborů dávky
+ */
+static void batchAdd(tBatchFile **files, int *count, int *size, const char *path, bool owned){
+	if(*count >= *size){
+		*size = *size > 0 ? *size * 2 : BATCH_FILES_CHUNK;
+		*files = safeRealloc(*files, *size * sizeof(tBatchFile));
+	}
+	(*files)[*count].path = path;
+	(*files)[*count].owned = owned;
+	(*files)[*count].size = 0;
+	(*files)[*count].retval = 0;
+	(*count)++;
+}
+
+/**
+ * Načte seznam cest ze souboru (jedna na řádek, prázdné řádky se přeskočí)
+ * 
+ * @return bool Seznam se podařilo přečíst
+ */
+static bool batchReadList(const char *listPath, tBatchFile **files, int *count, int *size){
+	FILE *list = fopen(listPath, "r");
+	if(list == NULL) return false;
+
+	char *line = NULL;
+	size_t lineSize = 0;
+	ssize_t len;
+	while((len = getline(&line, &lineSize, list)) >= 0){
+		while(len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+			line[--len] = '\0';
+		if(len == 0) continue;
+
+		char *path = safeMalloc(len + 1);
+		memcpy(path, line, len + 1);
+		batchAdd(files, count, size, path, true);
+	}
+
+	free(line);
+	fclose(list);
+	return true;
+}
+
+/**
+ * Porovnání souborů podle velikosti (sestupně)
+ */
+static int batchCompareSize(const void *a, const void *b){
+	long sizeA = (*(tBatchFile *const *)a)->size;
+	long sizeB = (*(tBatchFile *const *)b)->size;
+	return sizeA < sizeB ? 1 : sizeA > sizeB ? -1 : 0;
+}
+
+/**
+ * Porovnání souborů podle jména bez cesty
+ */
+static int batchCompareName(const void *a, const void *b){
+	return strcmp(batchBaseName((*(tBatchFile *const *)a)->path), batchBaseName((*(tBatchFile *const *)b)->path));
+}
+
+/**
+ * Vypíše chyby souboru na stderr, když nejde vytvořit jeho .err (každý řádek
+ * začíná cestou ke zdrojovému souboru, výpisy vláken se neproplétají)
+ */
+static void batchErrorsToStderr(const char *path, const char *errPath, const char *errors){
+	flockfile(stderr);
+	fprintf(stderr, "%s: [INTERNAL] Cannot create %s\n", path, errPath);
+	while(*errors != '\0'){
+		const char *end = strchr(errors, '\n');
+		int len = end != NULL ? (int)(end - errors) : (int)strlen(errors);
+		fprintf(stderr, "%s: %.*s\n", path, len, errors);
+		errors += len + (end != NULL);
+	}
+	funlockfile(stderr);
+}
+
+/**
+ * Přeloží jeden soubor dávky
+ * 
+ * @return int Návratový kód překladu
+ */
+static int batchCompileFile(pCompiler compiler, const char *outDir, const char *path){
+	char *codePath = batchOutPath(outDir, path, ".code");
+	char *errPath = batchOutPath(outDir, path, ".err");
+
+	// Chyby se sbírají v paměti, soubor .err vznikne jen pokud nějaké jsou
+	char *errors = NULL;
+	size_t errorsLen = 0;
+	FILE *err = open_memstream(&errors, &errorsLen);
+	if(err == NULL){
+		fprintf(stderr, "[INTERNAL] Fatal error - cannot allocate memory\n");
+		exit(99);
+	}
+
+	int retval;
+	FILE *input = fopen(path, "r");
+	FILE *output = input != NULL ? fopen(codePath, "w") : NULL;
+	if(input == NULL){
+		fprintf(err, "[INTERNAL] Cannot open %s\n", path);
+		retval = 99;
+	}else if(output == NULL){
+		fprintf(err, "[INTERNAL] Cannot create %s\n", codePath);
+		retval = 99;
+	}else{
+		ifj18_set_errors(compiler, err);
+		retval = ifj18_compile(compiler, input, output);
+	}
+
+	if(output != NULL && fclose(output) != 0 && retval == 0){
+		fprintf(err, "[INTERNAL] Cannot write %s\n", codePath);
+		retval = 99;
+	}
+	if(input != NULL) fclose(input);
+	fclose(err);
+
+	if(errorsLen > 0){
+		FILE *errFile = fopen(errPath, "w");
+		if(errFile != NULL){
+			fwrite(errors, 1, errorsLen, errFile);
+			fclose(errFile);
+		}else{
+			batchErrorsToStderr(path, errPath, errors);
+		}
+	}else{
+		// Chyby z předchozího překladu stejného souboru už neplatí
+		remove(errPath);
+	}
+
+	free(errors);
+	free(codePath);
+	free(errPath);
+	return retval;
+}
+
+/**
+ * Vlákno dávky - bere soubory z fronty, dokud nějaké zbývají
+ */
+static void *batchWorker(void *arg){
+	tBatchQueue *queue = arg;
+	pCompiler compiler = ifj18_create(queue->options);
+
+	while(true){
+		pthread_mutex_lock(&queue->lock);
+		tBatchFile *file = queue->next < queue->count ? queue->order[queue->next++] : NULL;
+		pthread_mutex_unlock(&queue->lock);
+		if(file == NULL) break;
+
+		file->retval = batchCompileFile(compiler, queue->outDir, file->path);
+	}
+
+	ifj18_destroy(compiler);
+	return NULL;
+}
+
+int batchCompile(const tOptions *options, const char *outDir, const char **args, int argCount, int jobs){
+	tBatchFile *files = NULL;
+	int count = 0;
+	int size = 0;
+	int retval = 0;
+
+	// Bez složky pro výstupy by chyby jednotlivých souborů neměly kam jít
+	struct stat dirStat;
+	if(stat(outDir, &dirStat) != 0 || !S_ISDIR(dirStat.st_mode) || access(outDir, W_OK | X_OK) != 0){
+		fprintf(stderr, "[INTERNAL] Output directory %s does not exist or is not writable\n", outDir);
+		return 99;
+	}
+
+	for(int i = 0; i < argCount; i++){
+		if(args[i][0] == '@'){
+			if(!batchReadList(&args[i][1], &files, &count, &size)){
+				fprintf(stderr, "[INTERNAL] Cannot read file list %s\n", &args[i][1]);
+				retval = 99;
+			}
+		}else{
+			batchAdd(&files, &count, &size, args[i], false);
+		}
+	}
+
+	tBatchFile **order = safeMalloc((count + 1) * sizeof(tBatchFile *));
+	for(int i = 0; i < count; i++){
+		struct stat st;
+		files[i].size = stat(files[i].path, &st) == 0 ? (long)st.st_size : 0;
+		order[i] = &files[i];
+	}
+
+	// Výstupy se jmenují podle souboru bez cesty, stejná jména by se přepsala
+	qsort(order, count, sizeof(tBatchFile *), batchCompareName);
+	for(int i = 1; i < count; i++){
+		if(batchCompareName(&order[i - 1], &order[i]) == 0){
+			fprintf(stderr, "[INTERNAL] Files %s and %s have the same name\n", order[i - 1]->path, order[i]->path);
+			retval = 99;
+		}
+	}
+
+	if(retval == 0){
+		// Největší soubory první, aby na konci nečekala vlákna na jeden velký soubor
+		qsort(order, count, sizeof(tBatchFile *), batchCompareSize);
+
+		if(jobs <= 0) jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+		if(jobs > count) jobs = count;
+		if(jobs < 1) jobs = 1;
+
+		tBatchQueue queue = {
+			.options = options,
+			.outDir = outDir,
+			.order = order,
+			.count = count,
+			.next = 0
+		};
+		pthread_mutex_init(&queue.lock, NULL);
+
+		// Hlavní vlákno pracuje také, vytváří se jen jobs - 1 dalších
+		pthread_t *threads = safeMalloc(jobs * sizeof(pthread_t));
+		int started = 0;
+		while(started < jobs - 1 && pthread_create(&threads[started], NULL, batchWorker, &queue) == 0)
+			started++;
+		batchWorker(&queue);
+		for(int i = 0; i < started; i++)
+			pthread_join(threads[i], NULL);
+
+		free(threads);
+		pthread_mutex_destroy(&queue.lock);
+
+		for(int i = 0; i < count; i++){
+			printf("%d %s\n", files[i].retval, files[i].path);
+			if(retval == 0) retval = files[i].retval;
+		}
+	}
+
+	for(int i = 0; i < count; i++)
+		if(files[i].owned) free((char *)files[i].path);
+	free(order);
+	free(files);
+
+	return retval;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file batch.h
+ * 
+ * Dávkový překlad mnoha souborů v jednom procesu
+ * 
+ * IFJ Projekt 2018, Tým 13
+ * 
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+#pragma once
+#include <stdio.h>
+#include <stdbool.h>
+#include "ifj18.h"
+
+/**
+ * Počáteční velikost pole souborů načtených ze seznamu
+ */
+#define BATCH_FILES_CHUNK 64
+
+/**
+ * Jeden soubor dávky
+ */
+typedef struct BatchFile{
+	const char *path;	//!< Cesta ke zdrojovému souboru
+	bool owned;			//!< Cesta je alokovaná (ze seznamu souborů)
+	long size;			//!< Velikost souboru (větší soubory se překládají dřív)
+	int retval;			//!< Návratový kód překladu
+} tBatchFile;
+
+/**
+ * Přeloží soubory na více vláknech. Pro každý soubor vznikne v outDir
+ * <jméno>.code s vygenerovaným kódem a <jméno>.err s chybami (jen pokud nějaké
+ * jsou). Na stdout se v pořadí souborů vypíše "<návratový kód> <cesta>"
+ * 
+ * @param options Nastavení překladače
+ * @param outDir Složka pro výstupy (musí existovat)
+ * @param args Cesty ke zdrojovým souborům, @soubor je seznam cest (jedna na řádek)
+ * @param argCount Počet položek args
+ * @param jobs Počet vláken (0 = počet procesorů)
+ * @return int 0, pokud se vše přeložilo, jinak návratový kód prvního chybného souboru
+ */
+int batchCompile(const tOptions *options, const char *outDir, const char **args, int argCount, int jobs);
@@ -0,0 +1,269 @@
+/**
+ * @file cache.c
+ * 
+ * Mezipaměť přeložených programů na disku
+ * 
+ * IFJ Projekt 2018, Tým 13
+ * 
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+// fmemopen(), open_memstream(), utimensat() a fcntl() zámky jsou součástí POSIX
+#define _POSIX_C_SOURCE 200809L
+#include "cache.h"
+#include "common.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Záznam nalezený při procházení složky cache
+ */
+typedef struct CacheEntry{
+	char *path;				//!< Cesta k záznamu
+	long size;				//!< Velikost záznamu
+	struct timespec used;	//!< Čas posledního použití (mtime)
+} tCacheEntry;
+
+/**
+ * Sestaví cestu k souboru ve složce cache
+ * 
+ * @return char* Cesta (je nutné uvolnit přes free())
+ */
+static char *cachePath(const char *dir, const char *name){
+	char *path = safeMalloc(strlen(dir) + strlen(name) + 2);
+	sprintf(path, "%s/%s", dir, name);
+	return path;
+}
+
+/**
+ * Přičte zásah nebo minutí do souboru se statistikou (sdílený více procesy, chráněný zámkem)
+ */
+static void cacheCount(const char *dir, bool hit, unsigned long *hits, unsigned long *misses){
+	char *path = cachePath(dir, "stats");
+	int fd = open(path, O_RDWR | O_CREAT, 0666);
+	free(path);
+	*hits = *misses = 0;
+	if(fd < 0) return;
+
+	struct flock lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET };
+	while(fcntl(fd, F_SETLKW, &lock) != 0 && errno == EINTR);
+
+	char buffer[64];
+	ssize_t len = read(fd, buffer, sizeof(buffer) - 1);
+	buffer[len > 0 ? len : 0] = '\0';
+	if(sscanf(buffer, "%lu %lu", hits, misses) != 2)
+		*hits = *misses = 0;
+
+	if(hit) (*hits)++;
+	else (*misses)++;
+
+	len = sprintf(buffer, "%lu %lu\n", *hits, *misses);
+	if(ftruncate(fd, 0) != 0 || pwrite(fd, buffer, len, 0) != len)
+		fprintf(stderr, "[INTERNAL] Cannot update cache statistics\n");
+
+	close(fd);
+}
+
+/**
+ * Porovnání záznamů podle času použití (nejstarší první)
+ */
+static int cacheCompareUsed(const void *a, const void *b){
+	const struct timespec *x = &((const tCacheEntry *)a)->used;
+	const struct timespec *y = &((const tCacheEntry *)b)->used;
+	if(x->tv_sec != y->tv_sec) return x->tv_sec < y->tv_sec ? -1 : 1;
+	if(x->tv_nsec != y->tv_nsec) return x->tv_nsec < y->tv_nsec ? -1 : 1;
+	return 0;
+}
+
+/**
+ * Projde záznamy cache, a pokud jejich velikost překročí maxSize, smaže nejdéle nepoužité
+ * 
+ * @param total Uloží velikost záznamů, které zůstaly
+ * @return int Počet záznamů, které zůstaly
+ */
+static int cacheTrim(const char *dir, long maxSize, long *total){
+	*total = 0;
+	DIR *d = opendir(dir);
+	if(d == NULL) return 0;
+
+	tCacheEntry *entries = NULL;
+	int count = 0;
+	int size = 0;
+	struct dirent *item;
+	while((item = readdir(d)) != NULL){
+		size_t nameLen = strlen(item->d_name);
+		if(nameLen <= strlen(CACHE_EXT) || strcmp(item->d_name + nameLen - strlen(CACHE_EXT), CACHE_EXT) != 0)
+			continue;
+
+		char *path = cachePath(dir, item->d_name);
+		struct stat st;
+		if(stat(path, &st) != 0){
+			free(path);
+			continue;
+		}
+
+		if(count >= size){
+			size = size > 0 ? size * 2 : 64;
+			entries = safeRealloc(entries, size * sizeof(tCacheEntry));
+		}
+		entries[count].path = path;
+		entries[count].size = st.st_size;
+		entries[count].used = st.st_mtim;
+		*total += st.st_size;
+		count++;
+	}
+	closedir(d);
+
+	int kept = count;
+	if(*total > maxSize){
+		qsort(entries, count, sizeof(tCacheEntry), cacheCompareUsed);
+		for(int i = 0; i < count && *total > maxSize; i++){
+			if(unlink(entries[i].path) == 0 || errno == ENOENT){
+				*total -= entries[i].size;
+				kept--;
+			}
+		}
+	}
+
+	for(int i = 0; i < count; i++)
+		free(entries[i].path);
+	free(entries);
+	return kept;
+}
+
+/**
+ * Pokusí se najít překlad v cache. Při zásahu vypíše uložený kód a chyby
+ * 
+ * @param retval Uloží návratový kód uloženého překladu
+ * @return bool Záznam byl nalezen
+ */
+static bool cacheLookup(const char *path, const char *header, const char *source, size_t sourceLen, int *retval){
+	FILE *file = fopen(path, "rb");
+	if(file == NULL) return false;
+
+	size_t len;
+	char *entry = readAll(file, &len);
+	fclose(file);
+
+	// Hlavička: <magic a identita> <návratový kód> <délka zdroje> <délka kódu> <délka chyb>
+	size_t headerLen = strlen(header);
+	unsigned long srcLen, codeLen, errLen;
+	int dataPos = 0;
+	bool hit = len > headerLen && memcmp(entry, header, headerLen) == 0 &&
+		sscanf(entry + headerLen, " %d %lu %lu %lu%n", retval, &srcLen, &codeLen, &errLen, &dataPos) == 4 &&
+		entry[headerLen + dataPos++] == '\n' && len - headerLen - dataPos == srcLen + codeLen + errLen &&
+		srcLen == sourceLen && memcmp(entry + headerLen + dataPos, source, sourceLen) == 0;
+
+	if(hit){
+		const char *code = entry + headerLen + dataPos + srcLen;
+		fwrite(code, 1, codeLen, stdout);
+		fwrite(code + codeLen, 1, errLen, stderr);
+		// Čas změny slouží jako čas posledního použití
+		utimensat(AT_FDCWD, path, NULL, 0);
+	}
+
+	free(entry);
+	return hit;
+}
+
+/**
+ * Uloží překlad do cache (přes dočasný soubor, aby souběžný překlad nenačetl nedokončený záznam)
+ */
+static void cacheStore(const char *path, const char *header, int retval, const char *source, size_t sourceLen,
+		const char *code, size_t codeLen, const char *errors, size_t errorsLen){
+	char *tmp = safeMalloc(strlen(path) + 32);
+	sprintf(tmp, "%s.tmp.%ld", path, (long)getpid());
+
+	FILE *file = fopen(tmp, "wb");
+	if(file == NULL){
+		free(tmp);
+		return;
+	}
+
+	fprintf(file, "%s %d %lu %lu %lu\n", header, retval, (unsigned long)sourceLen, (unsigned long)codeLen, (unsigned long)errorsLen);
+	fwrite(source, 1, sourceLen, file);
+	fwrite(code, 1, codeLen, file);
+	fwrite(errors, 1, errorsLen, file);
+
+	bool failed = ferror(file);
+	if(fclose(file) != 0 || failed || rename(tmp, path) != 0)
+		unlink(tmp);
+	free(tmp);
+}
+
+int cacheCompile(const tOptions *options, const char *dir, long maxSize, bool stats){
+	size_t sourceLen;
+	char *source = readAll(stdin, &sourceLen);
+
+	uint64_t identity = compilerIdentity();
+	unsigned flags = options->stackCalls | options->unchecked << 1 | options->literalStats << 2 | options->emitStats << 3;
+
+	char header[64];
+	sprintf(header, "%s %016llx %u", CACHE_MAGIC, (unsigned long long)identity, flags);
+
+	char name[32];
+	uint64_t key = hashFnv64(hashFnv64(HASH_FNV64_INIT, header, strlen(header)), source, sourceLen);
+	sprintf(name, "%016llx%s", (unsigned long long)key, CACHE_EXT);
+
+	if(mkdir(dir, 0777) != 0 && errno != EEXIST)
+		fprintf(stderr, "[INTERNAL] Cannot create cache directory %s\n", dir);
+	char *path = cachePath(dir, name);
+
+	int retval;
+	// Uložená doba fází by neodpovídala tomuto překladu
+	bool hit = !options->timePhases && cacheLookup(path, header, source, sourceLen, &retval);
+
+	if(!hit){
+		char *code = NULL;
+		size_t codeLen = 0;
+		char *errors = NULL;
+		size_t errorsLen = 0;
+		FILE *output = open_memstream(&code, &codeLen);
+		FILE *err = open_memstream(&errors, &errorsLen);
+		FILE *input = sourceLen > 0 ? fmemopen(source, sourceLen, "r") : fopen("/dev/null", "r");
+		if(output == NULL || err == NULL || input == NULL){
+			fprintf(stderr, "[INTERNAL] Fatal error - cannot allocate memory\n");
+			exit(99);
+		}
+
+		pCompiler compiler = ifj18_create(options);
+		ifj18_set_errors(compiler, err);
+		retval = ifj18_compile(compiler, input, output);
+		ifj18_destroy(compiler);
+		fclose(input);
+		fclose(output);
+		fclose(err);
+
+		fwrite(code, 1, codeLen, stdout);
+		fwrite(errors, 1, errorsLen, stderr);
+
+		// Vnitřní chyba (např. nedostatek paměti) nezávisí jen na vstupu
+		if(retval != 99 && !options->timePhases){
+			cacheStore(path, header, retval, source, sourceLen, code, codeLen, errors, errorsLen);
+			long total;
+			cacheTrim(dir, maxSize, &total);
+		}
+
+		free(code);
+		free(errors);
+	}
+
+	unsigned long hits, misses;
+	cacheCount(dir, hit, &hits, &misses);
+	if(stats){
+		long total;
+		int entries = cacheTrim(dir, maxSize, &total);
+		fprintf(stderr, "[STATS] Cache: %s, %lu hits, %lu misses (%.1f %% hits), %d entries, %ld of %ld bytes\n",
+			hit ? "hit" : "miss", hits, misses, 100.0 * hits / (hits + misses), entries, total, maxSize);
+	}
+
+	free(path);
+	free(source);
+	return retval;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file cache.h
+ * 
+ * Mezipaměť přeložených programů na disku
+ * 
+ * Klíčem je obsah zdrojového kódu, nastavení překladače a identita
+ * spustitelného souboru překladače (po novém sestavení se cache nepoužije).
+ * 
+ * IFJ Projekt 2018, Tým 13
+ * 
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+#pragma once
+#include <stdio.h>
+#include <stdbool.h>
+#include "ifj18.h"
+
+/**
+ * Výchozí největší velikost cache v bajtech
+ */
+#define CACHE_DEFAULT_SIZE (64L * 1024 * 1024)
+
+/**
+ * Přípona záznamů v cache
+ */
+#define CACHE_EXT ".ifjc"
+
+/**
+ * Verze formátu záznamu (na začátku každého záznamu)
+ */
+#define CACHE_MAGIC "IFJ18CACHE1"
+
+/**
+ * Přeloží program ze stdin na stdout přes cache. Při zásahu se vypíše uložený
+ * kód a chyby bez překladu, jinak se program přeloží a výsledek uloží
+ * (zápisem do dočasného souboru a přejmenováním). Při překročení maxSize
+ * se mažou nejdéle nepoužité záznamy.
+ * 
+ * @param options Nastavení překladače
+ * @param dir Složka cache (vytvoří se, pokud neexistuje)
+ * @param maxSize Největší velikost všech záznamů v bajtech
+ * @param stats Na konci vypsat na stderr statistiku zásahů cache
+ * @return int Návratový kód překladu
+ */
+int cacheCompile(const tOptions *options, const char *dir, long maxSize, bool stats);
@@ -12,63 +12,114 @@
  */
 
 #include "codegen.h"
+#include "context.h"
 
+void codeInit(){
+	memset(&ctx->code, 0, sizeof(struct cGenState));
+	ctx->code.stackSize = IFWHILE_STACK_CHUNK_SIZE;
+	ctx->code.stackTop = -1;
+	ctx->code.params = 1;
+}
+
+void codeDispose(){
+	pcGenState gen = &ctx->code;
+
+	if(gen->stack != NULL){
+		// Po chybě mohou zůstat zachycené podmínky neukončených cyklů
+		for(int i = 0; i <= gen->stackTop; i++)
+			free(gen->stack[i].cond);
+		free(gen->stack);
+	}
+
+	for(int i = 0; i < gen->funcCodesCount; i++)
+		free(gen->funcCodes[i]);
+	free(gen->funcCodes);
+
+	codeDisposeLiterals();
+	codeDisposeLocals(&gen->mainInlineLocals);
+	codeDisposeLocals(&gen->funcInlineLocals);
+	while(gen->inlineFuncs != NULL){
+		pcInlineFunc next = gen->inlineFuncs->next;
+		codeDisposeLocals(&gen->inlineFuncs->inlineLocals);
+		free(gen->inlineFuncs->params);
+		free(gen->inlineFuncs->body);
+		free(gen->inlineFuncs);
+		gen->inlineFuncs = next;
+	}
+	free(gen->callArgs);
+	free(gen->callArgTypes);
+	free(gen->defParamIds);
+	free(gen->reuseCode);
+
+	codeInit();
+}
 
 void codeFromToken(tType type, pToken token, psTree table){
-	static int ifCounter = 0;
-	static int whileCounter = 0;
-	static int stackSize = IFWHILE_STACK_CHUNK_SIZE;
-	static pcStackItem stack = NULL; // Stack if/while, true = if
-	static int stackTop = -1;
-
-	static char *id; // Poslední načtené id
-	
-	static int assign = false; // Provádí se přiřazení do proměnné
-	static char *assignId; // Id proměnné, do které se přiřazuje
-	
-	static int params = 1; // Počet parametrů
-	
-	static bool callFunc = false; // Volá se funkce
-	static bool callPrint = false; // Jedná se o volání print
-	static char *callId; // Id volané funkce
-	
-	static bool defFunc = false; // Definujeme funkci
-	static bool defTerm = false; // Přečetli jsme terminál def
-	static char *defId = false; // Id definované funkce
-	static bool defParams = false; // Definujeme parametry funkce
-
-
-	if(stack == NULL){ //pokud ještě neproběhla alokace pro ifWhile -> jen poprvé
-		stack = safeMalloc(stackSize * sizeof(struct cStackItem)); 
-	}
-
-	if(stackTop + 1 >= stackSize){ //pokud je ifWhile plný
-		stackSize += IFWHILE_STACK_CHUNK_SIZE;
-		stack = safeRealloc(stack, stackSize * sizeof(int));
+	pcGenState gen = &ctx->code;
+
+	// Parser volá generování ještě jednou za koncem souboru (bez tokenu)
+	if(token == NULL) return;
+
+	if(gen->stack == NULL){ //pokud ještě neproběhla alokace pro ifWhile -> jen poprvé
+		gen->stack = safeMalloc(gen->stackSize * sizeof(struct cStackItem)); 
+
+		// Proměnné hlavního těla jsou známé až na konci, definují se za koncem těla
+		// (tělo se tak nemusí zachytávat a vypisuje se rovnou)
+		outStr("CREATEFRAME\nPUSHFRAME\nJUMP $main$vars\nLABEL $main$body\n");
+	}
+
+	if(gen->stackTop + 1 >= gen->stackSize){ //pokud je ifWhile plný
+		gen->stackSize += IFWHILE_STACK_CHUNK_SIZE;
+		gen->stack = safeRealloc(gen->stack, gen->stackSize * sizeof(struct cStackItem));
+	}
+
+	if(gen->reuseEnd != NULL){
+		// Tělo nezměněné funkce se jen zkontroluje, výstup výrazů se zahodí
+		if(token != gen->reuseEnd->nextToken) return;
+
+		free(outCaptureEnd());
+		gen->funcCodes = safeRealloc(gen->funcCodes, (gen->funcCodesCount + 1) * sizeof(char *));
+		gen->funcCodes[gen->funcCodesCount++] = gen->reuseCode;
+		gen->reuseCode = NULL;
+		gen->reuseEnd = NULL;
+		gen->labels = gen->mainLabels;
 	}
 
 	switch(type){
 		case T_ASSIGN:
-			assign = true; //pro výpis move
-			assignId = id;
+			gen->assign = true; //pro výpis move
+			gen->assignId = gen->id;
 			break;
 
 		case T_ID:
 			if(strcmp(token->data, "print") == 0){ // Výpis write instrukce
-				callPrint = true;
-			}else if(defTerm){ // Je to id definice funkce
-				defId = token->data;
-				printf("JUMP %s$end\nLABEL %s$body\n", defId, defId);
-				defTerm = false;
+				gen->callPrint = true;
+			}else if(gen->defTerm){ // Je to id definice funkce
+				gen->defId = token->data;
+				gen->defTerm = false;
+				gen->defCallsFunc = false;
+				gen->defTailSelf = false;
+				gen->defParamCount = 0;
 			}else{ // Id funkcí a proměnných
-				id = token->data;
+				gen->id = token->data;
 			}
 			break;
 
 		case T_DEF:
-			defParams = true;
-			defFunc = true;
-			defTerm = true;
+			// Funkce čísluje návěští od nuly, hlavní tělo pak pokračuje svými čítači
+			gen->mainLabels = gen->labels;
+			memset(&gen->labels, 0, sizeof(struct cLabels));
+
+			// Kód nezměněné funkce se převezme z předchozího překladu
+			gen->reuseCode = incrementalLookup(token, &gen->reuseEnd);
+			if(gen->reuseCode != NULL){
+				outCaptureStart();
+				break;
+			}
+
+			gen->defParams = true;
+			gen->defFunc = true;
+			gen->defTerm = true;
 			break;
 
 		case N_DEFVARID:
@@ -76,23 +127,59 @@ void codeFromToken(tType type, pToken token, psTree table){
 			if(token->type == T_EOL){
 				pToken prev = token->prevToken;
 				if(prev->type == T_ID){
-					printf("CREATEFRAME\n");
-					if(symTabSearch(&table, prev->data) == NULL){
-						// je to funkce
-						printf("CALL %s\n", prev->data);
-					}else{
+					pcInlineFunc inlineFunc = NULL;
+					// Hodnota příkazu je potřeba jen na konci funkce (návratová hodnota)
+					bool live = gen->defFunc && codeIsTailPosition(token, gen->stack, gen->stackTop);
+
+					if(symTabSearch(&table, prev->data) != NULL){
 						// je to proměnná
-						printf("DEFVAR TF@$return\nMOVE TF@$return LF@%s\n", prev->data);
+						if(live){
+							outStr("CREATEFRAME\n");
+							outPrintf("DEFVAR TF@$return\nMOVE TF@$return LF@%s\n", prev->data);
+						}else if(gen->assign){
+							outPrintf("MOVE LF@%s LF@%s\n", gen->assignId, prev->data);
+							gen->assign = false;
+						}
+					}else if((inlineFunc = codeFindInline(prev->data, 0)) != NULL){
+						// je to funkce, jejíž tělo se vloží na místo volání
+						codeEmitInline(inlineFunc, NULL, gen->defFunc ? &gen->funcInlineLocals : &gen->mainInlineLocals);
+					}else{
+						// je to funkce
+						if(codeIsInlineBuiltin(prev->data)){
+							// výsledek se uloží rovnou do přiřazované proměnné
+							codeInlineBuiltin(prev->data, NULL, NULL, 0, gen->assign && !live ? gen->assignId : NULL);
+							if(!live) gen->assign = false;
+						}else if(gen->defFunc && !codeIsBuiltin(prev->data) && codeIsTailPosition(token, gen->stack, gen->stackTop)){
+							// volání na konci funkce -> skok místo CALL
+							gen->defTailSelf |= codeTailCall(prev->data, NULL, 0, gen->defId, gen->defParamIds, gen->defParamCount, table);
+							gen->defCallsFunc = true;
+						}else if(ctx->options.stackCalls && !codeIsBuiltin(prev->data)){
+							// výsledek se vrátí na datovém zásobníku
+							outInstr("CALL", "", prev->data);
+							gen->exprValue = true;
+							if(gen->defFunc) gen->defCallsFunc = true;
+						}else{
+							outStr("CREATEFRAME\n");
+							outInstr("CALL", "", prev->data);
+							if(gen->defFunc && !codeIsBuiltin(prev->data)) gen->defCallsFunc = true;
+						}
 					}
 				}
 			}
 			break;
 
+		case N_EXPR:
+		case N_EXPR_O:
+			// Výsledek výrazu zůstane na zásobníku, kam se uloží se rozhodne na konci příkazu
+			gen->exprValue = true;
+			break;
+
 		case N_FUNC:
-			printf("CREATEFRAME\n");
-			if(!callPrint){ //pokud nejde o funkci print
-				callId = id;
-				callFunc = true;
+			if(!gen->callPrint){ //pokud nejde o funkci print
+				gen->callId = gen->id;
+				gen->callFunc = true;
+				gen->callBuiltin = codeIsInlineBuiltin(gen->id);
+				gen->callInline = gen->callBuiltin ? NULL : codeFindInline(gen->id, -1);
 			}
 			break;
 
@@ -100,137 +187,764 @@ void codeFromToken(tType type, pToken token, psTree table){
 			{}//-> aby si překladač nestěžoval
 			pToken prevToken = token->prevToken;
 
-			char *tokenVal = NULL;
-			switch(prevToken->type){ //zjistím typ předchozího tokenu (terminál)
-				case T_INTEGER:
-					tokenVal = intToInterpret(prevToken->data);
-					break;
-				case T_FLOAT:
-					tokenVal = floatToInterpret(prevToken->data);
-					break;
-				case T_STRING:
-					tokenVal = stringToInterpret(prevToken->data);
-					break;
-				case T_NIL:
-					tokenVal = nilToInterpret();
-					break;
-				case T_TRUE:
-					tokenVal = trueToInterpret();
-					break;
-				case T_FALSE:
-					tokenVal = falseToInterpret();
-					break;
-				case T_ID:
-					tokenVal = varToInterpret(prevToken->data);
-				default: break;
-			}
+			char *tokenVal = codeLiteral(prevToken);
 			
 			if(tokenVal == NULL) break;
-			else if(callPrint){ // Jde o volání funkce print -> WRITE <hodnota>
-				printf("WRITE %s\n", tokenVal);
-			}else if(defParams){ // Jde o definici funkce
-				//printf("DEFVAR %s\nMOVE %s LF@%%%i\n", tokenVal, tokenVal, params);
-				printf("MOVE %s LF@%%%i\n", tokenVal, params);
-				params++;
-			}else{ // Jde o volání funkce -> DEFVAR + MOVE
-				printf("DEFVAR TF@%%%i\n", params);
-				printf("MOVE TF@%%%i %s\n", params, tokenVal);
-				params++;
+			else if(gen->callPrint){ // Jde o volání funkce print -> WRITE <hodnota>
+				outInstr("WRITE", "", tokenVal);
+			}else if(gen->callFunc){ // Volání funkce -> argumenty se vypíšou až na konci řádku
+				if(gen->params > gen->callArgsSize){
+					gen->callArgsSize += CALL_ARGS_CHUNK_SIZE;
+					gen->callArgs = safeRealloc(gen->callArgs, gen->callArgsSize * sizeof(char *));
+					gen->callArgTypes = safeRealloc(gen->callArgTypes, gen->callArgsSize * sizeof(tType));
+				}
+				gen->callArgs[gen->params - 1] = tokenVal;
+				gen->callArgTypes[gen->params - 1] = prevToken->type;
+				gen->params++;
+			}else if(gen->defParams){ // Jde o definici funkce
+				// Parametry se přesunou z LF@%i v prologu funkce
+				if(gen->params > gen->defParamsSize){
+					gen->defParamsSize += CALL_ARGS_CHUNK_SIZE;
+					gen->defParamIds = safeRealloc(gen->defParamIds, gen->defParamsSize * sizeof(char *));
+				}
+				gen->defParamIds[gen->params - 1] = prevToken->data;
+				gen->defParamCount = gen->params;
+				gen->params++;
 			}
-			
-			free(tokenVal);
 			break;
 
 		case T_EOL: //nulování
-			params = 1; // "vynuluju" počet parametrů 
+			{}
+			// Hodnota příkazu je potřeba jen na konci funkce (návratová hodnota)
+			bool live = gen->defFunc && codeIsTailPosition(token, gen->stack, gen->stackTop);
+
+			if(gen->callFunc){ // Volání funkce
+				if(gen->callBuiltin){
+					// výsledek se uloží rovnou do přiřazované proměnné, pokud ji argumenty nečtou
+					char *dest = NULL;
+					if(gen->assign && !live && !codeArgsUse(gen->callArgs, gen->params - 1, gen->assignId)) dest = gen->assignId;
+					codeInlineBuiltin(gen->callId, gen->callArgs, gen->callArgTypes, gen->params - 1, dest);
+					if(dest != NULL) gen->assign = false;
+				}else if(gen->callInline != NULL){
+					if(gen->params - 1 == gen->callInline->paramCount)
+						codeEmitInline(gen->callInline, gen->callArgs, gen->defFunc ? &gen->funcInlineLocals : &gen->mainInlineLocals);
+				}else if(gen->defFunc && !codeIsBuiltin(gen->callId) && codeIsTailPosition(token, gen->stack, gen->stackTop)){
+					// volání na konci funkce -> skok místo CALL
+					gen->defTailSelf |= codeTailCall(gen->callId, gen->callArgs, gen->params - 1, gen->defId, gen->defParamIds, gen->defParamCount, table);
+					gen->defCallsFunc = true;
+				}else if(ctx->options.stackCalls && !codeIsBuiltin(gen->callId)){
+					// argumenty i výsledek se předají přes datový zásobník
+					for(int i = 0; i < gen->params - 1; i++)
+						outInstr("PUSHS", "", gen->callArgs[i]);
+					outInstr("CALL", "", gen->callId);
+					gen->exprValue = true;
+					if(gen->defFunc) gen->defCallsFunc = true;
+				}else{
+					outStr("CREATEFRAME\n");
+					for(int i = 0; i < gen->params - 1; i++){ // DEFVAR + MOVE
+						outPrintf("DEFVAR TF@%%%i\n", i + 1);
+						outPrintf("MOVE TF@%%%i %s\n", i + 1, gen->callArgs[i]);
+					}
+					outInstr("CALL", "", gen->callId);
+					if(gen->defFunc && !codeIsBuiltin(gen->callId)) gen->defCallsFunc = true;
+				}
+
+				gen->callBuiltin = false;
+				gen->callInline = NULL;
+				gen->callFunc = false;
+			}
+
+			gen->params = 1; // "vynuluju" počet parametrů 
+
+			if(gen->callPrint){ //řádek s print funkcí
+				if(live || gen->assign)
+					outStr("CREATEFRAME\nDEFVAR TF@$return\nMOVE TF@$return nil@nil\n");
+				gen->callPrint = false;
+			}
 
-			if(callFunc){ // Volání funkce
-				printf("CALL %s\n", callId);
-				callFunc = false;
+			if(gen->defParams){
+				// Tělo funkce se zachytí, aby ho šlo vložit na místo volání
+				outCaptureStart();
+				// Funkce s prázdným tělem vrací nil, jinak návratovou hodnotu nastaví poslední příkaz
+				pToken next = token->nextToken;
+				while(next != NULL && next->type == T_EOL) next = next->nextToken;
+				if(next != NULL && next->type == T_END)
+					outStr("CREATEFRAME\nDEFVAR TF@$return\nMOVE TF@$return nil@nil\n");
+				gen->defParams = false;
 			}
 
-			if(callPrint){ //řádek s print funkcí
-				printf("DEFVAR TF@$return\nMOVE TF@$return nil@nil\n");
-				callPrint = false;
+			if(gen->exprValue){ //řádek s výrazem
+				if(live){
+					outStr("CREATEFRAME\nDEFVAR TF@$return\nPOPS TF@$return\n");
+				}else if(gen->assign){
+					outInstr("POPS", "LF@", gen->assignId);
+					gen->assign = false;
+				}
+				gen->exprValue = false;
 			}
 
-			if(defParams){
-				printf("DEFVAR LF@$return\nCREATEFRAME\nDEFVAR TF@$return\nMOVE TF@$return nil@nil\n");
-				defParams = false;
+			if(gen->assign){ //řádek s přiřazením
+				outPrintf("MOVE LF@%s TF@$return\n", gen->assignId);
+				gen->assign = false;
 			}
 
-			if(assign){ //řádek s přiřazením
-				printf("MOVE LF@%s TF@$return\n", assignId);
-				assign = false;
+			if(gen->stackTop >= 0 && gen->stack[gen->stackTop].hoistEnd == token){
+				// Konec příkazů vytažených před cyklus -> začátek opakovaného těla
+				codeLabel("LABEL", "$while$", gen->stack[gen->stackTop].id, "$body");
+				gen->stack[gen->stackTop].hoistEnd = NULL;
 			}
 			break;
 
 		case T_THEN:
-			stackTop++;
-			if(stackTop >= stackSize){
-				stackSize += IFWHILE_STACK_CHUNK_SIZE;
-				stack = safeRealloc(stack, stackSize * sizeof(struct cStackItem));
-			}
-			stack[stackTop].id = ifCounter;
-			stack[stackTop].isIf = true;
-			ifCounter++; //kolikátej je to if
-			printf("CALL $checkIfReturnBool\n");
-			printf("JUMPIFNEQ $if$%i$else TF@$return bool@true\nMOVE TF@$return nil@nil\n", stack[stackTop].id);
+			gen->stackTop++;
+			if(gen->stackTop >= gen->stackSize){
+				gen->stackSize += IFWHILE_STACK_CHUNK_SIZE;
+				gen->stack = safeRealloc(gen->stack, gen->stackSize * sizeof(struct cStackItem));
+			}
+			gen->stack[gen->stackTop].id = gen->labels.ifCounter;
+			gen->stack[gen->stackTop].isIf = true;
+			gen->stack[gen->stackTop].cond = NULL;
+			gen->stack[gen->stackTop].hoistEnd = NULL;
+			gen->stack[gen->stackTop].live = gen->defFunc && codeIsTailPosition(codeBlockEnd(token), gen->stack, gen->stackTop - 1);
+			gen->labels.ifCounter++; //kolikátej je to if
+			outStr("CREATEFRAME\nDEFVAR TF@$return\nPOPS TF@$return\n");
+			gen->exprValue = false;
+			if(!ctx->options.unchecked) outStr("CALL $checkIfReturnBool\n");
+			codeLabel("JUMPIFNEQ", "$if$", gen->stack[gen->stackTop].id, "$else TF@$return bool@true");
+			// Prázdná větev vrací nil (jen pokud je podmínka posledním příkazem funkce)
+			if(gen->stack[gen->stackTop].live) outStr("MOVE TF@$return nil@nil\n");
 			break;
 
 		case T_ELSE:
-			printf("JUMP $if$%i$end\n", stack[stackTop].id);
-			printf("LABEL $if$%i$else\nMOVE TF@$return nil@nil\n", stack[stackTop].id);
+			codeLabel("JUMP", "$if$", gen->stack[gen->stackTop].id, "$end");
+			codeLabel("LABEL", "$if$", gen->stack[gen->stackTop].id, "$else");
+			if(gen->stack[gen->stackTop].live) outStr("MOVE TF@$return nil@nil\n");
 			break;
 		
 		case T_END:
-			if(stackTop >= 0){
-				if(stack[stackTop].isIf){
+			if(gen->stackTop >= 0){
+				if(gen->stack[gen->stackTop].isIf){
 					// je if
-					printf("LABEL $if$%i$end\n", stack[stackTop].id);
+					codeLabel("LABEL", "$if$", gen->stack[gen->stackTop].id, "$end");
 				}else{
 					// je while
-					printf("JUMP $while$%i$start\n", stack[stackTop].id);
-					printf("LABEL $while$%i$end\n", stack[stackTop].id);
+					if(gen->stack[gen->stackTop].cond != NULL){
+						// Cyklus s vytaženými příkazy -> podmínka se testuje na konci těla
+						codeEmitRelabeled(gen->stack[gen->stackTop].cond, NULL);
+						codeLabel("JUMPIFEQ", "$while$", gen->stack[gen->stackTop].id, "$body TF@$return bool@true");
+						free(gen->stack[gen->stackTop].cond);
+					}else{
+						codeLabel("JUMP", "$while$", gen->stack[gen->stackTop].id, "$start");
+					}
+					codeLabel("LABEL", "$while$", gen->stack[gen->stackTop].id, "$end");
 					
-					// While vždycky returnuje nil
-					printf("CREATEFRAME\nDEFVAR TF@$return\nMOVE TF@$return nil@nil\n");
+					// While vždycky returnuje nil (jen pokud je posledním příkazem funkce)
+					if(gen->defFunc && codeIsTailPosition(token, gen->stack, gen->stackTop - 1))
+						outStr("CREATEFRAME\nDEFVAR TF@$return\nMOVE TF@$return nil@nil\n");
 				}
-				stackTop--;
-			}else if(defFunc){//je to end funkce
-				printf("MOVE LF@$return TF@$return\nPOPFRAME\nRETURN\nLABEL %s\nPUSHFRAME\n", defId);
-				symTabDefvarPre(table);
-				printf("JUMP %s$body\nLABEL %s$end\n", defId, defId);
-				defFunc = false;
+				gen->stackTop--;
+			}else if(gen->defFunc){//je to end funkce
+				char *body = outCaptureEnd();
+
+				// Funkce se vypíše mimo hlavní tělo, s prologem před tělem
+				outCaptureStart();
+				if(ctx->options.stackCalls){
+					outPrintf("LABEL %s\nCREATEFRAME\nPUSHFRAME\n", gen->defId);
+					codeDefvarLocals(table, gen->defParamIds, gen->defParamCount);
+					for(int i = gen->defParamCount - 1; i >= 0; i--)
+						outInstr("POPS", "LF@", gen->defParamIds[i]);
+				}else{
+					outPrintf("LABEL %s\nPUSHFRAME\nDEFVAR LF@$return\n", gen->defId);
+					codeDefvarLocals(table, gen->defParamIds, gen->defParamCount);
+				}
+				symTabDefvarPre(gen->funcInlineLocals);
+				if(gen->defTailSelf) outPrintf("LABEL %s$tail\n", gen->defId);
+				outStr(body);
+				if(ctx->options.stackCalls)
+					outStr("PUSHS TF@$return\nPOPFRAME\nRETURN\n");
+				else
+					outStr("MOVE LF@$return TF@$return\nPOPFRAME\nRETURN\n");
+				gen->funcCodes = safeRealloc(gen->funcCodes, (gen->funcCodesCount + 1) * sizeof(char *));
+				gen->funcCodes[gen->funcCodesCount++] = outCaptureEnd();
+
+				// Malé nerekurzivní funkce si zapamatujeme pro vložení na místo volání
+				if(!gen->defCallsFunc && codeCountInstructions(body) <= INLINE_MAX_SIZE){
+					pcInlineFunc func = safeMalloc(sizeof(struct cInlineFunc));
+					func->id = gen->defId;
+					func->paramCount = gen->defParamCount;
+					func->params = safeMalloc(gen->defParamCount * sizeof(char *) + 1);
+					for(int i = 0; i < gen->defParamCount; i++)
+						func->params[i] = gen->defParamIds[i];
+					func->locals = table;
+					func->inlineLocals = gen->funcInlineLocals;
+					func->body = body;
+					func->next = gen->inlineFuncs;
+					gen->inlineFuncs = func;
+				}else{
+					// Jen kód funkcí, které se nevkládají, lze příště převzít
+					incrementalStore(gen->funcCodes[gen->funcCodesCount - 1]);
+					free(body);
+					codeDisposeLocals(&gen->funcInlineLocals);
+				}
+				gen->funcInlineLocals = NULL;
+				gen->defFunc = false;
+				gen->labels = gen->mainLabels;
 			}
 			break;
 
 		case T_WHILE:
-			stackTop++;
-			if(stackTop >= stackSize){
-				stackSize += IFWHILE_STACK_CHUNK_SIZE;
-				stack = safeRealloc(stack, stackSize * sizeof(struct cStackItem));
-			}
-			stack[stackTop].id = whileCounter;
-			stack[stackTop].isIf = false;
-			whileCounter++; //kolikátej je to while
-			printf("LABEL $while$%i$start\n", stack[stackTop].id);
+			gen->stackTop++;
+			if(gen->stackTop >= gen->stackSize){
+				gen->stackSize += IFWHILE_STACK_CHUNK_SIZE;
+				gen->stack = safeRealloc(gen->stack, gen->stackSize * sizeof(struct cStackItem));
+			}
+			gen->stack[gen->stackTop].id = gen->labels.whileCounter;
+			gen->stack[gen->stackTop].isIf = false;
+			gen->stack[gen->stackTop].cond = NULL;
+			gen->stack[gen->stackTop].live = false;
+			gen->stack[gen->stackTop].hoistEnd = codeLoopInvariantEnd(token, table);
+			gen->labels.whileCounter++; //kolikátej je to while
+
+			if(gen->stack[gen->stackTop].hoistEnd != NULL){
+				// Vytažené příkazy se provedou jednou po prvním testu podmínky,
+				// kód podmínky se zachytí, aby se dal zopakovat na konci těla
+				outCaptureStart();
+			}else{
+				codeLabel("LABEL", "$while$", gen->stack[gen->stackTop].id, "$start");
+			}
 			break;
 
 		case T_DO:
-			printf("JUMPIFNEQ $while$%i$end TF@$return bool@true\n", stack[stackTop].id);
+			outStr("CREATEFRAME\nDEFVAR TF@$return\nPOPS TF@$return\n");
+			gen->exprValue = false;
+			if(gen->stack[gen->stackTop].hoistEnd != NULL){
+				gen->stack[gen->stackTop].cond = outCaptureEnd();
+				outStr(gen->stack[gen->stackTop].cond);
+			}
+			codeLabel("JUMPIFNEQ", "$while$", gen->stack[gen->stackTop].id, "$end TF@$return bool@true");
 			break;
 
 		case T_EOF:
-			if(stack != NULL){ //uvolnění alokované paměti
-				free(stack);
-				stack = NULL;
-
-				printf("EXIT int@0\nLABEL $main\nCREATEFRAME\nPUSHFRAME\n");
+			if(gen->stack != NULL){
+				outStr("EXIT int@0\nLABEL $main$vars\n");
 				symTabDefvarPre(table);
-				printf("JUMP $main$main\n");
+				symTabDefvarPre(gen->mainInlineLocals);
+				outStr("JUMP $main$body\n");
+
+				for(int i = 0; i < gen->funcCodesCount; i++)
+					outStr(gen->funcCodes[i]);
+				generateBaseFunctions();
+
+				codeDispose(); //uvolnění alokované paměti
 			}
 			break;
 		default: break;
 	}
+}
+
+bool codeIsInlineBuiltin(char *id){
+	return strcmp(id, "length") == 0 ||
+		strcmp(id, "chr") == 0 ||
+		strcmp(id, "ord") == 0 ||
+		strcmp(id, "inputi") == 0 ||
+		strcmp(id, "inputf") == 0 ||
+		strcmp(id, "inputs") == 0;
+}
+
+void codeCheckArgType(char *arg, tType argType, tType expected, const char *typeName, const char *errLabel){
+	if(argType == T_ID){
+		// Typ proměnné je známý až za běhu
+		if(ctx->options.unchecked) return;
+		outPrintf("TYPE GF@$tmp %s\n", arg);
+		outPrintf("JUMPIFNEQ %s GF@$tmp string@%s\n", errLabel, typeName);
+	}else if(argType != expected){
+		// Literál špatného typu -> chyba nastane vždy
+		outInstr("JUMP", "", errLabel);
+	}
+}
+
+void codeInlineBuiltin(char *id, char **args, tType *argTypes, int argc, char *dest){
+	char *out;
+	if(dest == NULL){
+		out = safeMalloc(sizeof("TF@$return"));
+		strcpy(out, "TF@$return");
+		outStr("CREATEFRAME\nDEFVAR TF@$return\n");
+	}else{
+		out = varToInterpret(dest);
+	}
+
+	if(strcmp(id, "inputi") == 0){
+		outPrintf("READ %s int\n", out);
+	}else if(strcmp(id, "inputf") == 0){
+		outPrintf("READ %s float\n", out);
+	}else if(strcmp(id, "inputs") == 0){
+		outPrintf("READ %s string\n", out);
+	}else if(strcmp(id, "length") == 0 && argc == 1){
+		codeCheckArgType(args[0], argTypes[0], T_STRING, "string", "$length$error");
+		outPrintf("STRLEN %s %s\n", out, args[0]);
+	}else if(strcmp(id, "chr") == 0 && argc == 1){
+		codeCheckArgType(args[0], argTypes[0], T_INTEGER, "int", "$chr$error");
+		outPrintf("INT2CHAR %s %s\n", out, args[0]);
+	}else if(strcmp(id, "ord") == 0 && argc == 2){
+		codeCheckArgType(args[1], argTypes[1], T_INTEGER, "int", "$ord$error");
+		codeCheckArgType(args[0], argTypes[0], T_STRING, "string", "$length$error");
+		// Index mimo řetězec -> nil
+		outPrintf("MOVE %s nil@nil\n", out);
+		outPrintf("STRLEN GF@$tmp %s\n", args[0]);
+		outPrintf("LT GF@$tmp2 %s int@0\n", args[1]);
+		codeLabel("JUMPIFEQ", "$ord$", ctx->code.labels.ordCounter, "$end GF@$tmp2 bool@true");
+		outPrintf("LT GF@$tmp2 %s GF@$tmp\n", args[1]);
+		codeLabel("JUMPIFNEQ", "$ord$", ctx->code.labels.ordCounter, "$end GF@$tmp2 bool@true");
+		outPrintf("STRI2INT %s %s %s\n", out, args[0], args[1]);
+		codeLabel("LABEL", "$ord$", ctx->code.labels.ordCounter, "$end");
+		ctx->code.labels.ordCounter++;
+	}
+
+	free(out);
+}
+
+bool codeArgsUse(char **args, int argc, char *id){
+	for(int i = 0; i < argc; i++)
+		if(strncmp(args[i], "LF@", 3) == 0 && strcmp(&args[i][3], id) == 0) return true;
+	return false;
+}
+
+pToken codeBlockEnd(pToken token){
+	int depth = 0;
+	for(token = token->nextToken; token != NULL; token = token->nextToken){
+		if(token->type == T_IF || token->type == T_WHILE) depth++;
+		else if(token->type == T_END && depth-- == 0) break;
+	}
+	return token;
+}
+
+bool codeIsBuiltin(char *id){
+	return codeIsInlineBuiltin(id) ||
+		strcmp(id, "substr") == 0 ||
+		strcmp(id, "print") == 0;
+}
+
+int codeCountInstructions(char *code){
+	int count = 0;
+	for(; *code != '\0'; code++)
+		if(*code == EOL) count++;
+	return count;
+}
+
+pcInlineFunc codeFindInline(char *id, int params){
+	for(pcInlineFunc func = ctx->code.inlineFuncs; func != NULL; func = func->next)
+		if(strcmp(func->id, id) == 0)
+			return (params < 0 || func->paramCount == params) ? func : NULL;
+	return NULL;
+}
+
+void codeAddLocal(psTree *locals, char *id){
+	if(symTabSearch(locals, id) != NULL){
+		free(id);
+		return;
+	}
+
+	psData data = safeMalloc(sizeof(struct sData));
+	data->type = VAR;
+	data->defined = true;
+	data->localFrame = NULL;
+	data->params = 0;
+	symTabInsert(locals, id, data);
+}
+
+void codeDisposeLocals(psTree *locals){
+	if(locals == NULL || *locals == NULL) return;
+
+	codeDisposeLocals(&(*locals)->lptr);
+	codeDisposeLocals(&(*locals)->rptr);
+	free((*locals)->key);
+	free((*locals)->data);
+	free(*locals);
+	*locals = NULL;
+}
+
+char *codeInlineName(pcInlineFunc func, char *id){
+	char *out = safeMalloc(strlen(func->id) + strlen(id) + 3);
+	sprintf(out, "$%s$%s", func->id, id);
+	return out;
+}
+
+void codeInlineResetLocals(pcInlineFunc func, psTree tree, psTree *locals){
+	if(tree == NULL) return;
+
+	bool isParam = false;
+	for(int i = 0; i < func->paramCount; i++)
+		if(strcmp(func->params[i], tree->key) == 0) isParam = true;
+
+	if(!isParam){
+		char *name = codeInlineName(func, tree->key);
+		outPrintf("MOVE LF@%s nil@nil\n", name);
+		codeAddLocal(locals, name);
+	}
+
+	codeInlineResetLocals(func, tree->lptr, locals);
+	codeInlineResetLocals(func, tree->rptr, locals);
+}
+
+void codeEmitInline(pcInlineFunc func, char **args, psTree *locals){
+	// Parametry se předají přímo do přejmenovaných proměnných
+	for(int i = 0; i < func->paramCount; i++){
+		char *name = codeInlineName(func, func->params[i]);
+		outPrintf("MOVE LF@%s %s\n", name, args[i]);
+		codeAddLocal(locals, name);
+	}
+
+	// Lokální proměnné mají při každém volání výchozí hodnotu nil
+	codeInlineResetLocals(func, func->locals, locals);
+	codeInlineResetLocals(func, func->inlineLocals, locals);
+
+	// Tělo funkce s přejmenovanými proměnnými a návěštími
+	codeEmitRelabeled(func->body, func->id);
+}
+
+void codeEmitRelabeled(char *code, char *funcId){
+	// Návěští definovaná v kódu
+	int labelCount = 0;
+	char **labels = NULL;
+	for(char *line = code; *line != '\0'; line = strchr(line, EOL) + 1){
+		if(strncmp(line, "LABEL ", 6) == 0){
+			labels = safeRealloc(labels, (labelCount + 1) * sizeof(char *));
+			labels[labelCount++] = &line[6];
+		}
+	}
+
+	for(char *line = code; *line != '\0'; line = strchr(line, EOL) + 1){
+		int lineLen = strchr(line, EOL) - line;
+		bool isJump = strncmp(line, "LABEL ", 6) == 0 || strncmp(line, "JUMP", 4) == 0;
+		int word = 0;
+
+		for(int i = 0; i < lineLen; ){
+			int wordLen = 0;
+			while(i + wordLen < lineLen && line[i + wordLen] != ' ') wordLen++;
+
+			if(word > 0) outStr(" ");
+			if(funcId != NULL && wordLen > 3 && strncmp(&line[i], "LF@", 3) == 0){
+				outStr("LF@$");
+				outStr(funcId);
+				outWrite("$", 1);
+				outWrite(&line[i + 3], wordLen - 3);
+			}else{
+				outWrite(&line[i], wordLen);
+				if(isJump && word == 1){
+					for(int l = 0; l < labelCount; l++){
+						if(strncmp(labels[l], &line[i], wordLen) == 0 && 
+							(labels[l][wordLen] == EOL || labels[l][wordLen] == ' ')){
+							outWrite("$", 1);
+							codeLabelId(ctx->code.labels.relabelCounter);
+							break;
+						}
+					}
+				}
+			}
+
+			i += wordLen + 1;
+			word++;
+		}
+		outStr("\n");
+	}
+
+	free(labels);
+	ctx->code.labels.relabelCounter++;
+}
+
+void codeLabel(const char *opcode, const char *name, int id, const char *rest){
+	outStr(opcode);
+	outWrite(" ", 1);
+	outStr(name);
+	codeLabelId(id);
+	outStr(rest);
+	outWrite("\n", 1);
+}
+
+void codeLabelId(int id){
+	if(ctx->code.defFunc){
+		outStr(ctx->code.defId);
+		outWrite("$", 1);
+	}
+	outInt(id);
+}
+
+bool codeIsTailPosition(pToken token, pcStackItem stack, int level){
+	for(token = token->nextToken; token != NULL; token = token->nextToken){
+		if(token->type == T_EOL) continue;
+
+		if(token->type == T_ELSE){
+			// Konec větve then -> přeskočí se větev else až k END podmínky
+			token = codeBlockEnd(token);
+			if(token == NULL) return false;
+		}else if(token->type != T_END){
+			// Za voláním následuje další příkaz
+			return false;
+		}
+
+		if(level < 0) return true; // END definice funkce
+		if(!stack[level].isIf) return false; // END cyklu -> tělo se opakuje
+		level--;
+	}
+	return false;
+}
+
+bool codeTailCall(char *id, char **args, int argc, char *defId, char **params, int paramCount, psTree locals){
+	// Argumenty se nejdřív uloží na zásobník, můžou odkazovat na přepisované parametry
+	outStr("CLEARS\n");
+	for(int i = 0; i < argc; i++)
+		outInstr("PUSHS", "", args[i]);
+
+	if(strcmp(id, defId) == 0 && argc == paramCount){
+		// Rekurze -> přepíšou se parametry a skočí se na začátek těla
+		for(int i = argc - 1; i >= 0; i--)
+			outInstr("POPS", "LF@", params[i]);
+		codeTailResetLocals(locals, params, paramCount);
+		outPrintf("JUMP %s$tail\n", defId);
+		return true;
+	}else{
+		// Jiná funkce -> rámec volající funkce se zahodí, volaná vrátí rovnou do jejího volajícího
+		outStr("POPFRAME\n");
+		if(!ctx->options.stackCalls){
+			outStr("CREATEFRAME\n");
+			for(int i = argc; i > 0; i--)
+				outPrintf("DEFVAR TF@%%%i\nPOPS TF@%%%i\n", i, i);
+		}
+		outInstr("JUMP", "", id);
+		return false;
+	}
+}
+
+void codeTailResetLocals(psTree tree, char **params, int paramCount){
+	if(tree == NULL) return;
+
+	bool isParam = false;
+	for(int i = 0; i < paramCount; i++)
+		if(strcmp(params[i], tree->key) == 0) isParam = true;
+
+	if(!isParam)
+		outPrintf("MOVE LF@%s nil@nil\n", tree->key);
+
+	codeTailResetLocals(tree->lptr, params, paramCount);
+	codeTailResetLocals(tree->rptr, params, paramCount);
+}
+
+bool codeIsPureBuiltin(char *id){
+	return strcmp(id, "length") == 0 ||
+		strcmp(id, "chr") == 0 ||
+		strcmp(id, "ord") == 0 ||
+		strcmp(id, "substr") == 0;
+}
+
+int codeCountAssigns(pToken from, pToken to, char *id){
+	int count = 0;
+	for(; from != NULL && from != to; from = from->nextToken){
+		if(from->type == T_ID && from->nextToken != NULL && 
+			from->nextToken->type == T_ASSIGN && strcmp(from->data, id) == 0)
+			count++;
+	}
+	return count;
+}
+
+bool codeIsInvariantAssign(pToken stmt, pToken body, pToken end, psTree table){
+	if(stmt->type != T_ID || stmt->nextToken->type != T_ASSIGN) return false;
+
+	// Cílová proměnná se v cyklu nesmí přiřazovat jinde
+	char *target = stmt->data;
+	if(codeCountAssigns(body, end, target) != 1) return false;
+
+	pToken token = stmt->nextToken->nextToken;
+	bool builtin = false;
+	int hoisted;
+	if(token->type == T_ID && codeIsPureBuiltin(token->data)){
+		builtin = true;
+		token = token->nextToken;
+	}
+
+	for(; token->type != T_EOL; token = token->nextToken){
+		switch(token->type){
+			case T_ID:
+				// Jen proměnné, které se v cyklu nemění nebo se přiřazují ve vytažených příkazech
+				if(strcmp(token->data, target) == 0) return false;
+				hoisted = codeCountAssigns(body, stmt, token->data);
+				if(symTabSearch(&table, token->data) == NULL && hoisted == 0) return false;
+				if(codeCountAssigns(body, end, token->data) != hoisted) return false;
+				break;
+			case T_INTEGER:
+			case T_FLOAT:
+			case T_STRING:
+			case T_NIL:
+			case T_TRUE:
+			case T_FALSE:
+			case T_LBRCKT:
+			case T_RBRCKT:
+				break;
+			case T_COMMA:
+				if(!builtin) return false;
+				break;
+			case T_ADD:
+			case T_SUB:
+			case T_MUL:
+			case T_DIV:
+			case T_EQL:
+			case T_NEQ:
+			case T_LT:
+			case T_GT:
+			case T_LTE:
+			case T_GTE:
+			case T_NOT:
+			case T_AND:
+			case T_OR:
+				if(builtin) return false;
+				break;
+			default:
+				return false;
+		}
+	}
+	return true;
+}
+
+pToken codeLoopInvariantEnd(pToken token, psTree table){
+	// Tělo cyklu začíná za DO
+	while(token != NULL && token->type != T_DO) token = token->nextToken;
+	if(token == NULL) return NULL;
+	pToken body = token->nextToken;
+
+	// END cyklu
+	pToken end = codeBlockEnd(token);
+	if(end == NULL) return NULL;
+
+	// Vytáhnout lze jen souvislý úsek příkazů na začátku těla, jinak by se změnilo pořadí efektů
+	pToken hoistEnd = NULL;
+	for(pToken stmt = body; stmt != end; stmt = stmt->nextToken){
+		if(stmt->type == T_EOL) continue;
+		if(!codeIsInvariantAssign(stmt, body, end, table)) break;
+
+		while(stmt->type != T_EOL) stmt = stmt->nextToken;
+		hoistEnd = stmt;
+	}
+	return hoistEnd;
+}
+
+void codeDefvarLocals(psTree tree, char **params, int paramCount){
+	if(tree == NULL) return;
+
+	outInstr("DEFVAR", "LF@", tree->key);
+
+	int param = 0;
+	for(int i = 0; i < paramCount; i++)
+		if(strcmp(params[i], tree->key) == 0) param = i + 1;
+
+	// Při volání přes zásobník se parametry naplní až instrukcemi POPS
+	if(param > 0 && !ctx->options.stackCalls) outPrintf("MOVE LF@%s LF@%%%i\n", tree->key, param);
+	else if(param == 0) outPrintf("MOVE LF@%s nil@nil\n", tree->key);
+
+	codeDefvarLocals(tree->lptr, params, paramCount);
+	codeDefvarLocals(tree->rptr, params, paramCount);
+}
+
+char *codeLiteral(pToken token){
+	pcGenState gen = &ctx->code;
+	char *(*convert)(char *) = NULL;
+	const char *constant = NULL;
+
+	switch(token->type){
+		case T_INTEGER: convert = intToInterpret; break;
+		case T_FLOAT: convert = floatToInterpret; break;
+		case T_STRING: convert = stringToInterpret; break;
+		case T_ID: convert = varToInterpret; break;
+		case T_NIL: constant = "nil@nil"; break;
+		case T_TRUE: constant = "bool@true"; break;
+		case T_FALSE: constant = "bool@false"; break;
+		default: return NULL;
+	}
+
+	// Klíčová slova nemají text tokenu
+	const char *raw = token->data != NULL ? token->data : "";
+	gen->literalLookups++;
+
+	// FNV-1a přes typ a text tokenu
+	unsigned hash = 2166136261u ^ (unsigned)token->type;
+	hash *= 16777619u;
+	for(const char *c = raw; *c != '\0'; c++){
+		hash ^= (unsigned char)*c;
+		hash *= 16777619u;
+	}
+
+	if(gen->literals == NULL){
+		gen->literalsSize = LITERAL_POOL_SIZE;
+		gen->literals = safeMalloc(gen->literalsSize * sizeof(pcLiteral));
+		memset(gen->literals, 0, gen->literalsSize * sizeof(pcLiteral));
+	}
+
+	for(pcLiteral lit = gen->literals[hash & (gen->literalsSize - 1)]; lit != NULL; lit = lit->next){
+		if(lit->hash == hash && lit->type == token->type && strcmp(lit->raw, raw) == 0){
+			gen->literalHits++;
+			return lit->value;
+		}
+	}
+
+	// Při zaplnění na 3/4 se tabulka zvětší na dvojnásobek
+	if(gen->literalsCount + 1 > gen->literalsSize / 4 * 3){
+		unsigned newSize = gen->literalsSize * 2;
+		pcLiteral *newLiterals = safeMalloc(newSize * sizeof(pcLiteral));
+		memset(newLiterals, 0, newSize * sizeof(pcLiteral));
+		for(unsigned i = 0; i < gen->literalsSize; i++){
+			while(gen->literals[i] != NULL){
+				pcLiteral lit = gen->literals[i];
+				gen->literals[i] = lit->next;
+				lit->next = newLiterals[lit->hash & (newSize - 1)];
+				newLiterals[lit->hash & (newSize - 1)] = lit;
+			}
+		}
+		free(gen->literals);
+		gen->literals = newLiterals;
+		gen->literalsSize = newSize;
+	}
+
+	size_t rawLen = strlen(raw);
+	pcLiteral lit = safeMalloc(sizeof(struct cLiteral) + rawLen + 1);
+	memcpy(lit->raw, raw, rawLen + 1);
+	lit->type = token->type;
+	lit->hash = hash;
+	if(convert != NULL){
+		lit->value = convert(token->data);
+	}else{
+		lit->value = safeMalloc(strlen(constant) + 1);
+		strcpy(lit->value, constant);
+	}
+
+	lit->next = gen->literals[hash & (gen->literalsSize - 1)];
+	gen->literals[hash & (gen->literalsSize - 1)] = lit;
+	gen->literalsCount++;
+
+	return lit->value;
+}
+
+void codeDisposeLiterals(){
+	pcGenState gen = &ctx->code;
+
+	if(gen->literals == NULL) return;
+
+	if(ctx->options.literalStats){
+		fprintf(ctx->errors, "[STATS] Literals: %lu lookups, %lu hits (%.1f %%), %u converted\n",
+			gen->literalLookups, gen->literalHits,
+			gen->literalLookups > 0 ? 100.0 * gen->literalHits / gen->literalLookups : 0.0,
+			gen->literalsCount);
+	}
+
+	for(unsigned i = 0; i < gen->literalsSize; i++){
+		while(gen->literals[i] != NULL){
+			pcLiteral next = gen->literals[i]->next;
+			free(gen->literals[i]->value);
+			free(gen->literals[i]);
+			gen->literals[i] = next;
+		}
+	}
+	free(gen->literals);
+	gen->literals = NULL;
+	gen->literalsSize = 0;
+	gen->literalsCount = 0;
+	gen->literalLookups = 0;
+	gen->literalHits = 0;
 }
\ No newline at end of file
@@ -11,6 +11,7 @@
  * @author <xchalo16> Jan Chaloupka
  */
 
+#pragma once
 #include <stdio.h>
 #include <string.h>
 #include "scanner.h"
@@ -21,11 +22,133 @@
  */
 #define IFWHILE_STACK_CHUNK_SIZE 100
 
+/**
+ * Velikost alokační jednotky pole argumentů volané funkce
+ */
+#define CALL_ARGS_CHUNK_SIZE 8
+
+/**
+ * Nejvyšší počet instrukcí těla funkce, kterou lze vložit na místo volání
+ * (lze změnit při překladu přes -DINLINE_MAX_SIZE=n, hodnota 0 vkládání vypne)
+ */
+#ifndef INLINE_MAX_SIZE
+#define INLINE_MAX_SIZE 40
+#endif
+
+/**
+ * Počáteční počet řetězců tabulky převedených literálů (mocnina 2)
+ */
+#define LITERAL_POOL_SIZE 256
+
+/**
+ * Převedený literál (nebo proměnná) v zápisu interpretu
+ */
+typedef struct cLiteral{
+	tType type;				//!< Typ tokenu
+	unsigned hash;			//!< Hash typu a textu tokenu
+	char *value;			//!< Zápis v kódu interpretu (např. int@1)
+	struct cLiteral *next;	//!< Další literál se stejným indexem v tabulce
+	char raw[];				//!< Text tokenu ze zdrojového kódu
+} *pcLiteral;
+
 typedef struct cStackItem{
 	bool isIf;
 	int id;
+	char *cond;			//!< Kód podmínky cyklu, který se opakuje na konci těla (NULL = cyklus bez vytažených příkazů)
+	pToken hoistEnd;	//!< EOL posledního příkazu vytaženého před cyklus
+	bool live;			//!< Hodnota podmínky je návratovou hodnotou funkce
 } *pcStackItem;
 
+/**
+ * Funkce, jejíž tělo lze vložit přímo na místo volání
+ */
+typedef struct cInlineFunc{
+	char *id;					//!< Identifikátor funkce
+	int paramCount;				//!< Počet parametrů
+	char **params;				//!< Identifikátory parametrů (v pořadí)
+	psTree locals;				//!< Lokální tabulka proměnných funkce
+	psTree inlineLocals;		//!< Proměnné funkcí vložených do těla této funkce
+	char *body;					//!< Vygenerované tělo funkce (bez prologu a epilogu)
+	struct cInlineFunc *next;	//!< Další funkce v seznamu
+} *pcInlineFunc;
+
+/**
+ * Čítače číslovaných návěští. Každá funkce čísluje od nuly a její návěští
+ * obsahují jméno funkce, kód funkce tak nezávisí na zbytku programu
+ */
+struct cLabels{
+	int ifCounter;				//!< Čítač podmínek
+	int whileCounter;			//!< Čítač cyklů
+	int ordCounter;				//!< Čítač návěští vestavěné funkce ord
+	int relabelCounter;			//!< Čítač přejmenování návěští vloženého kódu
+	int checkCounter;			//!< Čítač návěští typových kontrol výrazů
+};
+
+/**
+ * Stav generátoru kódu (součást kontextu překladače)
+ */
+typedef struct cGenState{
+	struct cLabels labels;		//!< Čítače návěští právě generované funkce (nebo hlavního těla)
+	struct cLabels mainLabels;	//!< Čítače návěští hlavního těla během generování funkce
+	int stackSize;
+	pcStackItem stack;			//!< Stack if/while
+	int stackTop;
+
+	char *id;					//!< Poslední načtené id
+
+	bool assign;				//!< Provádí se přiřazení do proměnné
+	char *assignId;				//!< Id proměnné, do které se přiřazuje
+
+	bool exprValue;				//!< Hodnota výrazu zůstala na datovém zásobníku
+
+	int params;					//!< Počet parametrů
+
+	bool callFunc;				//!< Volá se funkce
+	bool callPrint;				//!< Jedná se o volání print
+	bool callBuiltin;			//!< Volá se vestavěná funkce, která se rozvine na místě
+	pcInlineFunc callInline;	//!< Volaná funkce, jejíž tělo se vloží na místo volání
+	char *callId;				//!< Id volané funkce
+	char **callArgs;			//!< Argumenty funkce vkládané na místo volání
+	tType *callArgTypes;		//!< Typy argumentů funkce vkládané na místo volání
+	int callArgsSize;			//!< Velikost pole argumentů
+
+	bool defFunc;				//!< Definujeme funkci
+	bool defTerm;				//!< Přečetli jsme terminál def
+	char *defId;				//!< Id definované funkce
+	bool defParams;				//!< Definujeme parametry funkce
+	char **defParamIds;			//!< Identifikátory parametrů definované funkce
+	int defParamsSize;			//!< Velikost pole parametrů
+	int defParamCount;			//!< Počet parametrů definované funkce
+	bool defCallsFunc;			//!< Tělo definované funkce volá uživatelskou funkci
+	bool defTailSelf;			//!< Tělo definované funkce se na konci volá rekurzivně
+
+	psTree mainInlineLocals;	//!< Proměnné vložených funkcí v hlavním těle programu
+	psTree funcInlineLocals;	//!< Proměnné vložených funkcí v definované funkci
+
+	char *reuseCode;			//!< Kód nezměněné funkce z předchozího překladu (její tělo se negeneruje)
+	pToken reuseEnd;			//!< Token end nezměněné funkce
+
+	pcInlineFunc inlineFuncs;	//!< Seznam funkcí, jejichž tělo lze vložit na místo volání
+	char **funcCodes;			//!< Kód definovaných funkcí, vypíše se za hlavní tělo programu
+	int funcCodesCount;
+
+	pcLiteral *literals;		//!< Tabulka převedených literálů (rozptylová tabulka se zřetězením)
+	unsigned literalsSize;
+	unsigned literalsCount;
+	unsigned long literalLookups;	//!< Počet dotazů na tabulku
+	unsigned long literalHits;		//!< Počet dotazů zodpovězených z tabulky
+} *pcGenState;
+
+/**
+ * Připraví generátor kódu na nový překlad
+ */
+void codeInit();
+
+/**
+ * Uvolní veškerou paměť generátoru kódu (i po chybě uprostřed překladu)
+ */
+void codeDispose();
+
 /**
  * Vygeneruje kód z tokenu, funkce je volána syntaktickým analyzátorem při každém načtení tokenu
  * 
@@ -33,4 +156,265 @@ typedef struct cStackItem{
  * @param token Aktuálně načtený token
  * @param table Lokální tabulka proměnných aktuální funkce
  */
-void codeFromToken(tType type, pToken token, psTree table);
\ No newline at end of file
+void codeFromToken(tType type, pToken token, psTree table);
+
+/**
+ * Zjistí, jestli se jedná o vestavěnou funkci, jejíž tělo se vloží přímo na místo volání
+ * (length, chr, ord, inputi, inputf a inputs)
+ * 
+ * @param id Identifikátor volané funkce
+ * @return true Funkce se rozvine na místě volání
+ * @return false Funkce se volá instrukcí CALL
+ */
+bool codeIsInlineBuiltin(char *id);
+
+/**
+ * Vygeneruje kontrolu typu argumentu vestavěné funkce. Kontrola se generuje jen
+ * pokud je argumentem proměnná, u literálu je typ znám už při překladu
+ * 
+ * @param arg Argument v zápisu interpretu
+ * @param argType Typ tokenu argumentu
+ * @param expected Očekávaný typ tokenu literálu
+ * @param typeName Očekávaný typ v zápisu interpretu (int, string, ...)
+ * @param errLabel Návěští, na které se skočí při chybném typu
+ */
+void codeCheckArgType(char *arg, tType argType, tType expected, const char *typeName, const char *errLabel);
+
+/**
+ * Vygeneruje tělo vestavěné funkce přímo na místo volání. Výsledek se uloží
+ * do nového TF@$return stejně jako po volání funkce, nebo rovnou do proměnné
+ * 
+ * @param id Identifikátor vestavěné funkce
+ * @param args Argumenty v zápisu interpretu
+ * @param argTypes Typy tokenů argumentů
+ * @param argc Počet argumentů
+ * @param dest Proměnná pro výsledek (NULL = TF@$return)
+ */
+void codeInlineBuiltin(char *id, char **args, tType *argTypes, int argc, char *dest);
+
+/**
+ * Zjistí, jestli argumenty volání čtou proměnnou
+ * 
+ * @param args Argumenty v zápisu interpretu
+ * @param argc Počet argumentů
+ * @param id Identifikátor proměnné
+ * @return true Některý z argumentů je proměnná id
+ * @return false Proměnná se v argumentech nevyskytuje
+ */
+bool codeArgsUse(char **args, int argc, char *id);
+
+/**
+ * Najde END bloku, který začíná za zadaným tokenem (vnořené bloky se přeskočí)
+ * 
+ * @param token Token, za kterým blok začíná (THEN, DO, ELSE)
+ * @return pToken Token END bloku (NULL pokud chybí)
+ */
+pToken codeBlockEnd(pToken token);
+
+/**
+ * Zjistí, jestli se jedná o vestavěnou funkci jazyka IFJ18
+ * 
+ * @param id Identifikátor funkce
+ * @return true Funkce je vestavěná
+ * @return false Funkce je definovaná uživatelem
+ */
+bool codeIsBuiltin(char *id);
+
+/**
+ * Spočítá instrukce ve vygenerovaném kódu
+ * 
+ * @param code Vygenerovaný kód
+ * @return int Počet instrukcí (řádků)
+ */
+int codeCountInstructions(char *code);
+
+/**
+ * Vyhledá funkci, jejíž tělo lze vložit na místo volání
+ * 
+ * @param id Identifikátor funkce
+ * @param params Počet argumentů volání (-1 pokud není ještě známý)
+ * @return pcInlineFunc Nalezená funkce (NULL pokud funkci nelze vložit)
+ */
+pcInlineFunc codeFindInline(char *id, int params);
+
+/**
+ * Přidá proměnnou vložené funkce do tabulky proměnných volajícího, 
+ * aby se zadefinovala v jeho prologu
+ * 
+ * @param locals Tabulka proměnných vložených funkcí
+ * @param id Identifikátor proměnné (tabulka ho převezme, případně uvolní)
+ */
+void codeAddLocal(psTree *locals, char *id);
+
+/**
+ * Zruší tabulku proměnných vložených funkcí včetně klíčů
+ * 
+ * @param locals Tabulka pro zrušení
+ */
+void codeDisposeLocals(psTree *locals);
+
+/**
+ * Vrátí přejmenovaný identifikátor proměnné vložené funkce, aby nekolidoval
+ * s proměnnými volajícího
+ * 
+ * @param func Vkládaná funkce
+ * @param id Původní identifikátor proměnné
+ * @return char* Nový identifikátor (je nutné uvolnit přes free())
+ */
+char *codeInlineName(pcInlineFunc func, char *id);
+
+/**
+ * Nastaví lokální proměnné vkládané funkce (mimo parametry) na nil
+ * 
+ * @param func Vkládaná funkce
+ * @param tree Strom proměnných vkládané funkce
+ * @param locals Tabulka proměnných vložených funkcí volajícího
+ */
+void codeInlineResetLocals(pcInlineFunc func, psTree tree, psTree *locals);
+
+/**
+ * Vloží tělo funkce na místo volání. Proměnné funkce se přejmenují a přidají 
+ * do rámce volajícího, návěští dostanou unikátní příponu. Výsledek volání
+ * je po vložení v TF@$return stejně jako po instrukci CALL
+ * 
+ * @param func Vkládaná funkce
+ * @param args Argumenty volání v zápisu interpretu
+ * @param locals Tabulka proměnných vložených funkcí volajícího
+ */
+void codeEmitInline(pcInlineFunc func, char **args, psTree *locals);
+
+/**
+ * Vypíše již vygenerovaný kód znovu, návěští v něm definovaná dostanou
+ * unikátní příponu (kód se tak smí ve výstupu vyskytovat vícekrát)
+ * 
+ * @param code Kód k vypsání
+ * @param funcId Funkce, podle které se přejmenují proměnné LF@ (NULL = beze změny)
+ */
+void codeEmitRelabeled(char *code, char *funcId);
+
+/**
+ * Zapíše do výstupu instrukci s číslovaným návěštím, např. "JUMP $if$3$end"
+ * (ve funkci foo "JUMP $if$foo$3$end")
+ * 
+ * @param opcode Operační kód instrukce
+ * @param name Začátek návěští před číslem
+ * @param id Číslo návěští
+ * @param rest Zbytek návěští a případné další operandy
+ */
+void codeLabel(const char *opcode, const char *name, int id, const char *rest);
+
+/**
+ * Zapíše do výstupu číslo návěští, ve funkci s předřazeným jménem funkce
+ * 
+ * @param id Číslo návěští
+ */
+void codeLabelId(int id);
+
+/**
+ * Zjistí, jestli je volání na konci těla funkce (jeho výsledek je rovnou
+ * návratovou hodnotou funkce)
+ * 
+ * @param token Token EOL za voláním
+ * @param stack Zásobník if/while
+ * @param level Vrchol zásobníku if/while
+ * @return true Volání je posledním příkazem funkce
+ * @return false Za voláním se provádí další kód
+ */
+bool codeIsTailPosition(pToken token, pcStackItem stack, int level);
+
+/**
+ * Vygeneruje volání na konci funkce jako skok. Rekurzivní volání přepíše
+ * parametry a skočí na začátek těla, volání jiné funkce nahradí rámec
+ * volající funkce a skočí na volanou funkci
+ * 
+ * @param id Identifikátor volané funkce
+ * @param args Argumenty volání v zápisu interpretu
+ * @param argc Počet argumentů
+ * @param defId Identifikátor funkce, ve které se volá
+ * @param params Identifikátory parametrů funkce, ve které se volá
+ * @param paramCount Počet parametrů funkce, ve které se volá
+ * @param locals Lokální tabulka proměnných funkce, ve které se volá
+ * @return true Volání je rekurzivní (skok na návěští <defId>$tail)
+ * @return false Volání jiné funkce
+ */
+bool codeTailCall(char *id, char **args, int argc, char *defId, char **params, int paramCount, psTree locals);
+
+/**
+ * Nastaví lokální proměnné (mimo parametry) na nil před dalším průchodem
+ * tělem funkce
+ * 
+ * @param tree Strom lokálních proměnných
+ * @param params Identifikátory parametrů
+ * @param paramCount Počet parametrů
+ */
+void codeTailResetLocals(psTree tree, char **params, int paramCount);
+
+/**
+ * Zjistí, které úvodní příkazy těla cyklu lze vytáhnout před cyklus. Jde o
+ * přiřazení výrazu nebo čisté vestavěné funkce (length, chr, ord, substr),
+ * jejichž operandy se v cyklu nemění (a nemění se tedy ani jejich typ),
+ * a cílová proměnná se v cyklu jinde nepřiřazuje
+ * 
+ * @param token Token WHILE
+ * @param table Lokální tabulka proměnných
+ * @return pToken EOL posledního vytaženého příkazu (NULL pokud nelze nic vytáhnout)
+ */
+pToken codeLoopInvariantEnd(pToken token, psTree table);
+
+/**
+ * Zjistí, jestli je příkaz přiřazením, jehož hodnota se v cyklu nemění
+ * 
+ * @param stmt První token příkazu
+ * @param body První token těla cyklu
+ * @param end Token END cyklu
+ * @param table Lokální tabulka proměnných
+ * @return true Příkaz lze vytáhnout před cyklus
+ * @return false Příkaz musí zůstat v cyklu
+ */
+bool codeIsInvariantAssign(pToken stmt, pToken body, pToken end, psTree table);
+
+/**
+ * Spočítá přiřazení do proměnné v úseku tokenů
+ * 
+ * @param from První token úseku
+ * @param to Token za koncem úseku
+ * @param id Identifikátor proměnné
+ * @return int Počet přiřazení
+ */
+int codeCountAssigns(pToken from, pToken to, char *id);
+
+/**
+ * Zjistí, jestli je vestavěná funkce bez vedlejších efektů (výsledek závisí
+ * jen na argumentech)
+ * 
+ * @param id Identifikátor funkce
+ * @return true Funkce je čistá
+ * @return false Funkce čte vstup nebo zapisuje výstup
+ */
+bool codeIsPureBuiltin(char *id);
+
+/**
+ * Zadefinuje lokální proměnné v prologu funkce. Parametry se inicializují
+ * předanými argumenty (při volání přes zásobník až následnými POPS), ostatní
+ * proměnné na nil
+ * 
+ * @param tree Strom lokálních proměnných funkce
+ * @param params Identifikátory parametrů (v pořadí)
+ * @param paramCount Počet parametrů
+ */
+void codeDefvarLocals(psTree tree, char **params, int paramCount);
+
+/**
+ * Vrátí literál nebo proměnnou v zápisu interpretu. Každý literál se převádí
+ * jen jednou, opakované výskyty vrací stejný řetězec z tabulky literálů
+ * 
+ * @param token Token literálu nebo identifikátoru proměnné
+ * @return char* Zápis v kódu interpretu (neuvolňovat) nebo NULL, pokud token není hodnota
+ */
+char *codeLiteral(pToken token);
+
+/**
+ * Vypíše do výpisu chyb překladu statistiku tabulky literálů a tabulku uvolní
+ * (statistika se vypíše jen s přepínačem --literal-stats)
+ */
+void codeDisposeLiterals();
@@ -11,9 +11,24 @@
  * @author <xchalo16> Jan Chaloupka
  */
 
+// fileno() a stat() jsou součástí POSIX
+#define _POSIX_C_SOURCE 200809L
 #include "common.h"
+#include "context.h"
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <limits.h>
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define STRING_SIMD 1
+#else
+#define STRING_SIMD 0
+#endif
 
-void *safeMalloc(size_t _Size){
+// Závorky kolem jména brání rozvinutí makra v sestavení se statistikou alokací
+void *(safeMalloc)(size_t _Size){
 	void *ret = malloc(_Size);
 	if(ret == NULL){
 		fprintf(stderr, "[INTERNAL] Fatal error - cannot allocate memory\n");
@@ -22,7 +37,7 @@ void *safeMalloc(size_t _Size){
 	return ret;
 }
 
-void *safeRealloc(void *_Block, size_t _Size){
+void *(safeRealloc)(void *_Block, size_t _Size){
 	void *ret = realloc(_Block, _Size);
 	if(ret == NULL){
 		fprintf(stderr, "[INTERNAL] Fatal error - cannot allocate memory\n");
@@ -31,71 +46,340 @@ void *safeRealloc(void *_Block, size_t _Size){
 	return ret;
 }
 
+uint64_t hashFnv64(uint64_t hash, const void *data, size_t len){
+	const unsigned char *bytes = data;
+	for(size_t i = 0; i < len; i++){
+		hash ^= bytes[i];
+		hash *= 1099511628211u;
+	}
+	return hash;
+}
+
+uint64_t compilerIdentity(){
+	struct stat st;
+
+	if(stat("/proc/self/exe", &st) == 0){
+		uint64_t id[5] = { st.st_dev, st.st_ino, st.st_size, st.st_mtim.tv_sec, st.st_mtim.tv_nsec };
+		return hashFnv64(HASH_FNV64_INIT, id, sizeof(id));
+	}
+
+	// Bez /proc alespoň čas překladu tohoto modulu
+	return hashFnv64(HASH_FNV64_INIT, __DATE__ " " __TIME__, sizeof(__DATE__ " " __TIME__));
+}
+
+char *readAll(FILE *file, size_t *len){
+	size_t size = 4096;
+	char *data = safeMalloc(size);
+	*len = 0;
+
+	size_t got;
+	while((got = fread(data + *len, 1, size - *len, file)) > 0){
+		*len += got;
+		if(*len == size){
+			size *= 2;
+			data = safeRealloc(data, size);
+		}
+	}
+	return data;
+}
+
+void outInit(FILE *file){
+	// Data zapsaná do souboru před překladem musí být na výstupu dřív
+	fflush(file);
+	ctx->out.file = file;
+	ctx->out.top = NULL;
+	ctx->out.len = 0;
+	ctx->out.written = 0;
+}
+
+void outDispose(){
+	// Po chybě překladu mohou zůstat nedokončená zachytávání
+	while(ctx->out.top != NULL) free(outCaptureEnd());
+}
+
+/**
+ * Zapíše do výstupu obsah bufferu a za něj další data (nejvýše jedním voláním writev)
+ */
+static void outFlushWith(const char *data, size_t len){
+	tOutState *out = &ctx->out;
+	int fd = fileno(out->file);
+	out->written += out->len + len;
+	emitStatsFeed(out->buffer, out->len);
+	emitStatsFeed(data, len);
+
+	if(fd < 0){
+		// Výstup bez deskriptoru (např. open_memstream) -> přes stdio
+		if(fwrite(out->buffer, 1, out->len, out->file) != out->len ||
+			(len > 0 && fwrite(data, 1, len, out->file) != len)){
+			fprintf(stderr, "[INTERNAL] Fatal error - cannot write output\n");
+			exit(99);
+		}
+		out->len = 0;
+		return;
+	}
+
+	struct iovec iov[2] = {
+		{ .iov_base = out->buffer, .iov_len = out->len },
+		{ .iov_base = (char *)data, .iov_len = len }
+	};
+	struct iovec *vec = iov;
+	int count = 2;
+
+	while(count > 0){
+		if(vec->iov_len == 0){
+			vec++;
+			count--;
+			continue;
+		}
+
+		ssize_t written = writev(fd, vec, count);
+		if(written < 0){
+			if(errno == EINTR) continue;
+			fprintf(stderr, "[INTERNAL] Fatal error - cannot write output\n");
+			exit(99);
+		}
+
+		// Částečný zápis -> pokračuje se od prvního nezapsaného bajtu
+		while(count > 0 && (size_t)written >= vec->iov_len){
+			written -= vec->iov_len;
+			vec++;
+			count--;
+		}
+		if(count > 0){
+			vec->iov_base = (char *)vec->iov_base + written;
+			vec->iov_len -= written;
+		}
+	}
+
+	out->len = 0;
+}
+
+void outFlush(){
+	outFlushWith(NULL, 0);
+}
+
+void outWrite(const char *data, size_t len){
+	tOutState *out = &ctx->out;
+	pOutBuffer top = out->top;
+
+	if(top == NULL){
+		if(out->len + len > OUT_FLUSH_SIZE){
+			// Velká data (např. zachycené tělo programu) se nekopírují
+			if(len >= OUT_FLUSH_SIZE) outFlushWith(data, len);
+			else{
+				outFlush();
+				memcpy(out->buffer, data, len);
+				out->len = len;
+			}
+			return;
+		}
+		memcpy(&out->buffer[out->len], data, len);
+		out->len += len;
+		return;
+	}
+
+	if(top->len + len + 1 > top->size){
+		while(top->len + len + 1 > top->size)
+			top->size *= 2;
+		top->data = safeRealloc(top->data, top->size);
+	}
+	memcpy(&top->data[top->len], data, len);
+	top->len += len;
+	top->data[top->len] = '\0';
+}
+
+void outStr(const char *str){
+	outWrite(str, strlen(str));
+}
+
+void outInt(int value){
+	char digits[12];
+	int pos = sizeof(digits);
+	unsigned int abs = value < 0 ? -(unsigned int)value : (unsigned int)value;
+
+	do{
+		digits[--pos] = '0' + abs % 10;
+		abs /= 10;
+	}while(abs > 0);
+	if(value < 0) digits[--pos] = '-';
+
+	outWrite(&digits[pos], sizeof(digits) - pos);
+}
+
+void outInstr(const char *opcode, const char *prefix, const char *operand){
+	outStr(opcode);
+	outWrite(" ", 1);
+	outStr(prefix);
+	outStr(operand);
+	outWrite("\n", 1);
+}
+
+void outPrintf(const char *format, ...){
+	char line[OUT_LINE_SIZE];
+	va_list args;
+	va_start(args, format);
+
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+	int len = vsnprintf(line, sizeof(line), format, argsCopy);
+	va_end(argsCopy);
+
+	if(len > 0 && (size_t)len < sizeof(line)){
+		outWrite(line, len);
+	}else if(len > 0){
+		// Dlouhý řádek (např. řetězcový literál) se formátuje do alokovaného místa
+		char *longLine = safeMalloc(len + 1);
+		vsnprintf(longLine, len + 1, format, args);
+		outWrite(longLine, len);
+		free(longLine);
+	}
+
+	va_end(args);
+}
+
+void outCaptureStart(){
+	pOutBuffer buffer = safeMalloc(sizeof(struct OutBuffer));
+	buffer->size = OUT_BUFFER_CHUNK_SIZE;
+	buffer->data = safeMalloc(buffer->size);
+	buffer->data[0] = '\0';
+	buffer->len = 0;
+	buffer->prev = ctx->out.top;
+	ctx->out.top = buffer;
+}
+
+char *outCaptureEnd(){
+	if(ctx->out.top == NULL) return NULL;
+
+	pOutBuffer buffer = ctx->out.top;
+	char *data = buffer->data;
+	ctx->out.top = buffer->prev;
+	free(buffer);
+
+	return data;
+}
+
+/**
+ * Zapíše jeden znak literálu, který se v interpretu zapisuje escape
+ * sekvencí. Index i se posune za zpracované znaky
+ * 
+ * @return char* Pozice ve výstupu za zapsanou sekvencí
+ */
+static char *stringEscapeChar(const char *raw, size_t *i, char *out){
+	char c = raw[*i];
+	char d1 = '3', d2 = '2';
+
+	if(c == '\\'){
+		(*i)++;
+		c = raw[*i];
+		if(c == '"'){
+			(*i)++;
+			*out = '"';
+			return out + 1;
+		}else if(c == 'n'){
+			d1 = '1';
+			d2 = '0';
+		}else if(c == 't'){
+			d1 = '0';
+			d2 = '9';
+		}else if(c == '\\'){
+			d1 = '9';
+		}else if(c == 'x'){
+			// Za \x je podle scanneru jedna nebo dvě šestnáctkové číslice
+			int l = isxdigit(raw[*i + 2]) ? 2 : 1;
+			int value = 0;
+			for(int d = 1; d <= l; d++){
+				c = raw[*i + d];
+				value = value * 16 + (isdigit(c) ? c - '0' : tolower(c) - 'a' + 10);
+			}
+			*i += l;
+			(*i)++;
+			out[0] = '\\';
+			out[1] = '0' + value / 100;
+			out[2] = '0' + value / 10 % 10;
+			out[3] = '0' + value % 10;
+			return out + 4;
+		}
+	}else if(c == '#'){
+		d2 = '5';
+	}
+
+	(*i)++;
+	out[0] = '\\';
+	out[1] = '0';
+	out[2] = d1;
+	out[3] = d2;
+	return out + 4;
+}
+
+#if STRING_SIMD
+/**
+ * Maska bajtů bloku 16 znaků, které nelze zapsat přímo (<= mezera, # a \)
+ */
+static inline unsigned stringSpecialMask(const char *p){
+	__m128i v = _mm_loadu_si128((const __m128i *)p);
+#if CHAR_MIN < 0
+	// char je znaménkový -> bajty nad 127 jsou také "<= mezera"
+	__m128i ctrl = _mm_cmplt_epi8(v, _mm_set1_epi8(' ' + 1));
+#else
+	__m128i ctrl = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(' ')), v);
+#endif
+	__m128i hash = _mm_cmpeq_epi8(v, _mm_set1_epi8('#'));
+	__m128i bs = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+	return _mm_movemask_epi8(_mm_or_si128(ctrl, _mm_or_si128(hash, bs)));
+}
+#endif
+
 char *stringToInterpret(char *rawString){
-	int rawLen = strlen(rawString);
-	
-	int max = rawLen + 1;
-	int pos = 7;
-	char *out = safeMalloc(sizeof(char) * (max + 20));
-	strcpy(out, "string@");
-
-	for(int i = 1; i < rawLen - 1; i++){
-		if(max <= pos + 4){
-			max += 100;
-			out = safeRealloc(out, sizeof(char) * max);
+	size_t rawLen = strlen(rawString);
+	size_t end = rawLen > 0 ? rawLen - 1 : 0; // Uzavírací uvozovka
+
+	// Každý znak se rozepíše nejvýše na 4, +16 pro zápis celého bloku za koncem
+	char *out = safeMalloc(sizeof(char) * (rawLen * 4 + 7 + 16));
+	memcpy(out, "string@", 7);
+	char *pos = &out[7];
+	size_t i = 1;
+
+#if STRING_SIMD
+	while(i + 16 <= end){
+		// Blok se zapíše celý, výstup se ale posune jen po první zvláštní znak
+		unsigned mask = stringSpecialMask(&rawString[i]);
+		_mm_storeu_si128((__m128i *)pos, _mm_loadu_si128((const __m128i *)&rawString[i]));
+		if(mask == 0){
+			pos += 16;
+			i += 16;
+			continue;
 		}
-		
-		out[pos] = '\\';
+
+		int run = __builtin_ctz(mask);
+		pos += run;
+		i += run;
 		if(rawString[i] == '\\'){
-			i++;
-			if(rawString[i] == '"'){
-				out[pos] = '"';
-				pos -= 3;
-			}else if(rawString[i] == 'n'){
-				out[pos+1] = '0';
-				out[pos+2] = '1';
-				out[pos+3] = '0';
-			}else if(rawString[i] == 't'){
-				out[pos+1] = '0';
-				out[pos+2] = '0';
-				out[pos+3] = '9';
-			}else if(rawString[i] == '\\'){
-				out[pos+1] = '0';
-				out[pos+2] = '9';
-				out[pos+3] = '2';
-			}else if(rawString[i] == 'x'){
-				int l = isxdigit(rawString[i+2])?2:1;
-				char hex[3] = {0};
-				hex[0] = rawString[i+1];
-				if(l > 1) hex[1] = rawString[i+2];
-				i += l;
-				sprintf(&out[pos+1], "%03ld", strtol(hex, NULL, 16));
-			}else{
-				out[pos+1] = '0';
-				out[pos+2] = '3';
-				out[pos+3] = '2';
-			}
-			pos += 3;
-		}else if(rawString[i] == '#'){
-			out[pos+1] = '0';
-			out[pos+2] = '3';
-			out[pos+3] = '5';
-			pos += 3;
-		}else if(rawString[i] <= ' '){
-			out[pos+1] = '0';
-			out[pos+2] = '3';
-			out[pos+3] = '2';
-			pos += 3;
+			pos = stringEscapeChar(rawString, &i, pos);
 		}else{
-			out[pos] = rawString[i];
+			// Bílé a řídicí znaky a # přímo, jsou nejčastější
+			pos[0] = '\\';
+			pos[1] = '0';
+			pos[2] = '3';
+			pos[3] = rawString[i] == '#' ? '5' : '2';
+			pos += 4;
+			i++;
 		}
+	}
+#endif
 
-		pos++;
+	while(i < end){
+		char c = rawString[i];
+		if(c > ' ' && c != '#' && c != '\\'){
+			*pos++ = c;
+			i++;
+		}else{
+			pos = stringEscapeChar(rawString, &i, pos);
+		}
 	}
+	*pos = '\0';
 
-	out[pos] = '\0';
-	out = safeRealloc(out, sizeof(char) * (pos + 1));
-	return out;
+	// Vrácení nevyužité části rezervy
+	return safeRealloc(out, sizeof(char) * (pos - out + 1));
 }
 
 char *intToInterpret(char *rawInt){
@@ -104,13 +388,13 @@ char *intToInterpret(char *rawInt){
 		// printf neumí rozeznat 0b
 		sprintf(out, "int@%ld", strtol(&rawInt[2], NULL, 2));
 	}else sprintf(out, "int@%ld", strtol(rawInt, NULL, 0));
-	return safeRealloc(out, strlen(out));
+	return safeRealloc(out, strlen(out) + 1);
 }
 
 char *floatToInterpret(char *rawFloat){
 	char *out = safeMalloc(sizeof(char) * (50));
 	sprintf(out, "float@%a", strtod(rawFloat, NULL));
-	return safeRealloc(out, strlen(out));
+	return safeRealloc(out, strlen(out) + 1);
 }
 
 char *trueToInterpret(){
@@ -149,42 +433,82 @@ char *funcToInterpret(char *id){
 	return out;
 }
 
-void generateBaseCode(){
-	printf(".IFJcode18\n\
+/**
+ * Hlavička kódu interpretu s globálními proměnnými
+ */
+static const char baseCode[] = ".IFJcode18\n\
 \n\
 DEFVAR GF@$tmp\n\
 DEFVAR GF@$tmp2\n\
-\n\
-JUMP $main\n\
-\n\
+DEFVAR GF@$lv\n\
+DEFVAR GF@$lt\n\
+DEFVAR GF@$rv\n\
+DEFVAR GF@$rt\n\
+\n";
+
+/**
+ * Pomocné a vestavěné funkce (vypisují se beze změny za kód programu),
+ * rozdělené na části kvůli maximální délce řetězcového literálu v C99
+ */
+static const char *const baseFunctions[] = {
+"\n\
+# Preddefinovane funkce\n\
 LABEL $checkIfBool\n\
-	CALL $getType\n\
-	JUMPIFNEQ $printTypeError TF@%%return string@bool\n\
+	POPS GF@$rv\n\
+	POPS GF@$lv\n\
+	TYPE GF@$rt GF@$rv\n\
+	TYPE GF@$lt GF@$lv\n\
+	JUMPIFNEQ $printTypeError GF@$lt string@bool\n\
+	JUMPIFNEQ $printTypeError GF@$rt string@bool\n\
+	PUSHS GF@$lv\n\
+	PUSHS GF@$rv\n\
 	RETURN\n\
 \n\
 LABEL $checkIfLtGt\n\
-	CALL $getType\n\
-	JUMPIFEQ $checkIfLtGt$end TF@%%return string@string\n\
-	JUMPIFEQ $checkIfLtGt$end TF@%%return string@int\n\
-	JUMPIFNEQ $printTypeError TF@%%return string@float\n\
+	POPS GF@$rv\n\
+	POPS GF@$lv\n\
+	TYPE GF@$rt GF@$rv\n\
+	TYPE GF@$lt GF@$lv\n\
+	JUMPIFNEQ $checkIfLtGt$promote GF@$lt GF@$rt\n\
+	JUMPIFEQ $checkIfLtGt$end GF@$lt string@int\n\
+	JUMPIFEQ $checkIfLtGt$end GF@$lt string@float\n\
+	JUMPIFNEQ $printTypeError GF@$lt string@string\n\
 	LABEL $checkIfLtGt$end\n\
+	PUSHS GF@$lv\n\
+	PUSHS GF@$rv\n\
 	RETURN\n\
+	LABEL $checkIfLtGt$promote\n\
+	CALL $promote\n\
+	JUMP $checkIfLtGt$end\n\
 \n\
 LABEL $checkIfEql\n\
-	CALL $getType\n\
-	\n\
-	JUMPIFEQ $decideEqlOp$diff TF@%%return string@different\n\
-	PUSHS TF@rv\n\
-	PUSHS TF@lv\n\
+	POPS GF@$rv\n\
+	POPS GF@$lv\n\
+	TYPE GF@$rt GF@$rv\n\
+	TYPE GF@$lt GF@$lv\n\
+	JUMPIFNEQ $checkIfEql$diff GF@$lt GF@$rt\n\
+	LABEL $checkIfEql$end\n\
+	PUSHS GF@$lv\n\
+	PUSHS GF@$rv\n\
 	RETURN\n\
-	\n\
-	LABEL $decideEqlOp$diff\n\
+	# int a float se porovnaji po prevodu, jine ruzne typy se nerovnaji\n\
+	LABEL $checkIfEql$diff\n\
+	JUMPIFEQ $checkIfEql$lint GF@$lt string@int\n\
+	JUMPIFNEQ $checkIfEql$false GF@$rt string@int\n\
+	JUMPIFNEQ $checkIfEql$false GF@$lt string@float\n\
+	INT2FLOAT GF@$rv GF@$rv\n\
+	JUMP $checkIfEql$end\n\
+	LABEL $checkIfEql$lint\n\
+	JUMPIFNEQ $checkIfEql$false GF@$rt string@float\n\
+	INT2FLOAT GF@$lv GF@$lv\n\
+	JUMP $checkIfEql$end\n\
+	LABEL $checkIfEql$false\n\
 	PUSHS bool@false\n\
 	PUSHS bool@true\n\
 	RETURN\n\
 \n\
 LABEL $decideDivOp\n\
-	JUMPIFEQ $decideDivOp$float TF@%%return string@float\n\
+	JUMPIFEQ $decideDivOp$float GF@$lt string@float\n\
 	IDIVS\n\
 	RETURN\n\
 	LABEL $decideDivOp$float\n\
@@ -192,74 +516,63 @@ LABEL $decideDivOp\n\
 	RETURN\n\
 \n\
 LABEL $checkIfAdd\n\
-	CALL $getType\n\
-	JUMPIFEQ $checkIfAdd$string TF@%%return string@string\n\
-	JUMPIFEQ $checkIfAdd$num TF@%%return string@int\n\
-	JUMPIFNEQ $printTypeError TF@%%return string@float\n\
-	LABEL $checkIfAdd$num\n\
-	ADDS\n\
+	POPS GF@$rv\n\
+	POPS GF@$lv\n\
+	TYPE GF@$rt GF@$rv\n\
+	TYPE GF@$lt GF@$lv\n\
+	JUMPIFNEQ $checkIfAdd$promote GF@$lt GF@$rt\n\
+	JUMPIFEQ $checkIfAdd$num GF@$lt string@int\n\
+	JUMPIFEQ $checkIfAdd$num GF@$lt string@float\n\
+	JUMPIFNEQ $printTypeError GF@$lt string@string\n\
+	CONCAT GF@$lv GF@$lv GF@$rv\n\
+	PUSHS GF@$lv\n\
 	RETURN\n\
-	LABEL $checkIfAdd$string\n\
-	POPS GF@$tmp2\n\
-	POPS GF@$tmp\n\
-	CONCAT GF@$tmp GF@$tmp GF@$tmp2\n\
-	PUSHS GF@$tmp\n\
+	LABEL $checkIfAdd$promote\n\
+	CALL $promote\n\
+	LABEL $checkIfAdd$num\n\
+	ADD GF@$lv GF@$lv GF@$rv\n\
+	PUSHS GF@$lv\n\
 	RETURN\n\
 \n\
 LABEL $checkIfNum\n\
-	CALL $getType\n\
-	JUMPIFEQ $checkIfNum$end TF@%%return string@int\n\
-	JUMPIFNEQ $printTypeError TF@%%return string@float\n\
+	POPS GF@$rv\n\
+	POPS GF@$lv\n\
+	TYPE GF@$rt GF@$rv\n\
+	TYPE GF@$lt GF@$lv\n\
+	JUMPIFNEQ $checkIfNum$promote GF@$lt GF@$rt\n\
+	JUMPIFEQ $checkIfNum$end GF@$lt string@int\n\
+	JUMPIFNEQ $printTypeError GF@$lt string@float\n\
 	LABEL $checkIfNum$end\n\
+	PUSHS GF@$lv\n\
+	PUSHS GF@$rv\n\
 	RETURN\n\
+	LABEL $checkIfNum$promote\n\
+	CALL $promote\n\
+	JUMP $checkIfNum$end\n\
 \n\
-LABEL $getType\n\
-	CREATEFRAME\n\
-	DEFVAR TF@%%return\n\
-	DEFVAR TF@lv\n\
-	DEFVAR TF@lt\n\
-	DEFVAR TF@rv\n\
-	DEFVAR TF@rt\n\
-	POPS TF@rv\n\
-	POPS TF@lv\n\
-	TYPE TF@lt TF@lv\n\
-	TYPE TF@rt TF@rv\n\
-	\n\
-	# defaultne nejsou stejneho typu\n\
-	MOVE TF@%%return string@different\n\
-	\n\
-	JUMPIFEQ $getType$if$1$1 TF@lt TF@rt\n\
-	JUMPIFEQ $getType$if$1$2 TF@lt string@int\n\
-	JUMPIFEQ $getType$if$1$3 TF@rt string@int\n\
-	JUMP $getType$if$1$end\n\
-	LABEL $getType$if$1$1 # jsou stejneho typu\n\
-		MOVE TF@%%return TF@lt\n\
-	JUMP $getType$if$1$end\n\
-	LABEL $getType$if$1$2 # lt je int\n\
-		JUMPIFNEQ $getType$if$2 TF@rt string@float\n\
-			MOVE TF@%%return TF@rt\n\
-			INT2FLOAT TF@lv TF@lv\n\
-		LABEL $getType$if$2\n\
-	JUMP $getType$if$1$end\n\
-	LABEL $getType$if$1$3 # rt je int\n\
-		JUMPIFNEQ $getType$if$3 TF@lt string@float\n\
-			MOVE TF@%%return TF@lt\n\
-			INT2FLOAT TF@rv TF@rv\n\
-		LABEL $getType$if$3\n\
-	LABEL $getType$if$1$end\n\
-	\n\
-	PUSHS TF@lv\n\
-	PUSHS TF@rv\n\
+# Operandy ruznych typu v GF@$lv a GF@$rv: int a float se prevedou na float\n\
+# (GF@$lt pak obsahuje string@float), jine kombinace jsou chyba\n\
+LABEL $promote\n\
+	JUMPIFEQ $promote$lint GF@$lt string@int\n\
+	JUMPIFNEQ $printTypeError GF@$rt string@int\n\
+	JUMPIFNEQ $printTypeError GF@$lt string@float\n\
+	INT2FLOAT GF@$rv GF@$rv\n\
+	RETURN\n\
+	LABEL $promote$lint\n\
+	JUMPIFNEQ $printTypeError GF@$rt string@float\n\
+	INT2FLOAT GF@$lv GF@$lv\n\
+	MOVE GF@$lt string@float\n\
 	RETURN\n\
 \n\
 LABEL $printTypeError\n\
 	WRITE string@\\010[RUNTIME]\\032Type\\032error\\032-\\032incompatible\\032types\\032(\n\
-	WRITE TF@lt\n\
+	WRITE GF@$lt\n\
 	WRITE string@\\032with\\032\n\
-	WRITE TF@rt\n\
+	WRITE GF@$rt\n\
 	WRITE string@)\n\
 	EXIT int@4\n\
-\n\
+\n",
+"\
 LABEL $checkDivByZero\n\
 	POPS GF@$tmp\n\
 	TYPE GF@$tmp2 GF@$tmp\n\
@@ -284,135 +597,60 @@ LABEL $checkIfReturnBool\n\
 	RETURN\n\
 \n\
 \n\
-LABEL inputi\n\
-	PUSHFRAME\n\
-	DEFVAR LF@$return\n\
-	READ LF@$return int\n\
-	POPFRAME\n\
-	RETURN\n\
-\n\
-LABEL inputf\n\
-	PUSHFRAME\n\
-	DEFVAR LF@$return\n\
-	READ LF@$return float\n\
-	POPFRAME\n\
-	RETURN\n\
-\n\
-LABEL inputs\n\
-	PUSHFRAME\n\
-	DEFVAR LF@$return\n\
-	READ LF@$return string\n\
-	POPFRAME\n\
-	RETURN\n\
-\n");
-	printf("\
-LABEL length\n\
-	PUSHFRAME\n\
-	DEFVAR LF@$return\n\
-	DEFVAR LF@type\n\
-	TYPE LF@type LF@%%1\n\
-	JUMPIFEQ length$cont LF@type string@string\n\
-		WRITE string@\\010[RUNTIME]\\032Type\\032error\\032-\\032Function\\032length()\\032expected\\032type\\032string\\010\n\
-		EXIT int@4\n\
-	LABEL length$cont\n\
-	STRLEN LF@$return LF@%%1\n\
-	POPFRAME\n\
-	RETURN\n\
-\n\
-LABEL chr\n\
-	PUSHFRAME\n\
-	DEFVAR LF@$return\n\
-	DEFVAR LF@type\n\
-	TYPE LF@type LF@%%1\n\
-	JUMPIFEQ chr$cont LF@type string@int\n\
-		WRITE string@\\010[RUNTIME]\\032Type\\032error\\032-\\032Function\\032chr()\\032expected\\032type\\032int\\010\n\
-		EXIT int@4\n\
-	LABEL chr$cont\n\
-	INT2CHAR LF@$return LF@%%1\n\
-	POPFRAME\n\
-	RETURN\n\
+LABEL $length$error\n\
+	WRITE string@\\010[RUNTIME]\\032Type\\032error\\032-\\032Function\\032length()\\032expected\\032type\\032string\\010\n\
+	EXIT int@4\n\
 \n\
-LABEL ord\n\
-	PUSHFRAME\n\
-	DEFVAR LF@$return\n\
-	TYPE GF@$tmp LF@%%2\n\
-	JUMPIFEQ ord$cont GF@$tmp string@int\n\
-		WRITE string@\\010[RUNTIME]\\032Type\\032error\\032-\\032Function\\032ord()\\032expected\\032second\\032parameter\\032type\\032int\\010\n\
-		EXIT int@4\n\
-	LABEL ord$cont\n\
-	DEFVAR LF@len\n\
-	MOVE LF@$return nil@nil\n\
-	CREATEFRAME\n\
-	DEFVAR TF@%%1\n\
-	MOVE TF@%%1 LF@%%1\n\
-	CALL length\n\
-	MOVE LF@len TF@$return\n\
-	CLEARS\n\
-	PUSHS LF@%%2\n\
-	PUSHS int@0\n\
-	LTS\n\
-	PUSHS LF@%%2\n\
-	PUSHS LF@len\n\
-	LTS\n\
-	NOTS\n\
-	ORS\n\
-	POPS TF@$return\n\
-	JUMPIFEQ ord$nil TF@$return bool@true\n\
-	STRI2INT LF@$return LF@%%1 LF@%%2\n\
-	LABEL ord$nil\n\
-	POPFRAME\n\
-	RETURN\n\
+LABEL $chr$error\n\
+	WRITE string@\\010[RUNTIME]\\032Type\\032error\\032-\\032Function\\032chr()\\032expected\\032type\\032int\\010\n\
+	EXIT int@4\n\
 \n\
+LABEL $ord$error\n\
+	WRITE string@\\010[RUNTIME]\\032Type\\032error\\032-\\032Function\\032ord()\\032expected\\032second\\032parameter\\032type\\032int\\010\n\
+	EXIT int@4\n\
+\n",
+"\
 LABEL substr\n\
 	PUSHFRAME\n\
 	DEFVAR LF@$return\n\
 	MOVE LF@$return nil@nil\n\
 	DEFVAR LF@len\n\
-	CREATEFRAME\n\
-	DEFVAR TF@%%1\n\
-	MOVE TF@%%1 LF@%%1\n\
-	CALL length\n\
-	MOVE LF@len TF@$return\n\
-	CLEARS\n\
-	PUSHS LF@%%2\n\
-	PUSHS int@0\n\
-	LTS\n\
-	PUSHS LF@%%2\n\
-	PUSHS LF@len\n\
-	GTS\n\
-	#NOTS\n\
-	PUSHS LF@%%3\n\
-	PUSHS int@0\n\
-	LTS\n\
-	ORS\n\
-	ORS\n\
-	POPS GF@$tmp\n\
-	JUMPIFEQ substr$1 GF@$tmp bool@true\n\
+	TYPE GF@$tmp LF@%1\n\
+	JUMPIFNEQ $length$error GF@$tmp string@string\n\
+	STRLEN LF@len LF@%1\n\
+	# Meze se kontroluji jen jednou: i < 0, i > length(s) nebo n < 0 -> nil\n\
+	LT GF@$tmp LF@%2 int@0\n\
+	JUMPIFEQ substr$end GF@$tmp bool@true\n\
+	GT GF@$tmp LF@%2 LF@len\n\
+	JUMPIFEQ substr$end GF@$tmp bool@true\n\
+	LT GF@$tmp LF@%3 int@0\n\
+	JUMPIFEQ substr$end GF@$tmp bool@true\n\
 	MOVE LF@$return string@\n\
-	ADD LF@%%3 LF@%%3 LF@%%2\n\
-	LABEL substr$2$cmp\n\
-	CLEARS\n\
-	PUSHS LF@%%2\n\
-	PUSHS LF@%%3\n\
-	LTS\n\
-	PUSHS LF@%%2\n\
-	PUSHS LF@len\n\
-	LTS\n\
-	ANDS\n\
-	POPS GF@$tmp\n\
-	JUMPIFNEQ substr$2$end GF@$tmp bool@true\n\
-	GETCHAR GF@$tmp LF@%%1 LF@%%2\n\
+	# Konec podretezce = min(i + n, length(s))\n\
+	ADD LF@%3 LF@%3 LF@%2\n\
+	LT GF@$tmp LF@%3 LF@len\n\
+	JUMPIFEQ substr$clamped GF@$tmp bool@true\n\
+	MOVE LF@%3 LF@len\n\
+	LABEL substr$clamped\n\
+	JUMPIFEQ substr$end LF@%2 LF@%3\n\
+	# Kopirovani po znacich bez datoveho zasobniku\n\
+	LABEL substr$loop\n\
+	GETCHAR GF@$tmp LF@%1 LF@%2\n\
 	CONCAT LF@$return LF@$return GF@$tmp\n\
-	ADD LF@%%2 LF@%%2 int@1\n\
-	JUMP substr$2$cmp\n\
-	LABEL substr$2$end\n\
-	LABEL substr$1\n\
-	\n\
+	ADD LF@%2 LF@%2 int@1\n\
+	JUMPIFNEQ substr$loop LF@%2 LF@%3\n\
+	LABEL substr$end\n\
 	POPFRAME\n\
 	RETURN\n\
-	\n\
 \n\
-# Konec preddefinovanych funkci\n\
-LABEL $main$main\n\
-\n");
+# Konec preddefinovanych funkci\n"
+};
+
+void generateBaseCode(){
+	outWrite(baseCode, sizeof(baseCode) - 1);
+}
+
+void generateBaseFunctions(){
+	for(size_t i = 0; i < sizeof(baseFunctions) / sizeof(baseFunctions[0]); i++)
+		outStr(baseFunctions[i]);
 }
\ No newline at end of file
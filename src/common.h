@@ -16,12 +16,57 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "ifj18.h"
 
 /**
  * Zkratka pro nový řádek
  */
 #define EOL '\n'
 
+/**
+ * Počáteční hodnota hashe FNV-1a (64 bit)
+ */
+#define HASH_FNV64_INIT 14695981039346656037u
+
+/**
+ * Počáteční velikost bufferu pro zachytávání výstupu (při zaplnění se zdvojnásobí)
+ */
+#define OUT_BUFFER_CHUNK_SIZE 1024
+
+/**
+ * Velikost bufferu výstupu do souboru
+ */
+#define OUT_FLUSH_SIZE 65536
+
+/**
+ * Velikost pomocného bufferu pro jeden řádek formátovaný přes outPrintf
+ */
+#define OUT_LINE_SIZE 256
+
+/**
+ * Buffer pro zachycení vygenerovaného kódu (místo výpisu do souboru)
+ */
+typedef struct OutBuffer{
+	char *data;				//!< Zachycený kód (ukončený nulou)
+	size_t len;				//!< Délka zachyceného kódu
+	size_t size;			//!< Velikost alokovaného místa
+	struct OutBuffer *prev;	//!< Vnější buffer (zachytávání lze zanořovat)
+} *pOutBuffer;
+
+/**
+ * Stav výstupu překladu (součást kontextu překladače)
+ */
+typedef struct OutState{
+	FILE *file;						//!< Výstup vygenerovaného kódu
+	pOutBuffer top;					//!< Aktuální buffer pro zachytávání výstupu (NULL = výpis do souboru)
+	size_t len;						//!< Počet bajtů v bufferu výstupu
+	size_t written;					//!< Počet bajtů zapsaných do souboru
+	char buffer[OUT_FLUSH_SIZE];	//!< Buffer výstupu, vypisuje se po celých blocích
+} tOutState;
+
 /**
  * Funguje stejně jako standartní funkce malloc, a navíc
  * pokud se nepovede alokovat paměť vypíše chybu na stderr a
@@ -43,6 +88,112 @@ void *safeMalloc(size_t _Size);
  */
 void *safeRealloc(void *_Block, size_t _Size);
 
+#ifdef ALLOC_STATS
+#include "allocstats.h"
+// Sestavení se statistikou alokací: každé volání předá své místo ve zdrojovém kódu
+#define safeMalloc(_Size) allocStatsMalloc((_Size), __FILE__, __LINE__)
+#define safeRealloc(_Block, _Size) allocStatsRealloc((_Block), (_Size), __FILE__, __LINE__)
+#define free(_Block) allocStatsFree(_Block)
+#endif
+
+/**
+ * Přidá blok dat do hashe FNV-1a (64 bit)
+ * 
+ * @param hash Dosavadní hash (na začátku HASH_FNV64_INIT)
+ * @param data Data
+ * @param len Délka dat
+ * @return uint64_t Nový hash
+ */
+uint64_t hashFnv64(uint64_t hash, const void *data, size_t len);
+
+/**
+ * Identita překladače pro klíče uložených výsledků překladu. Změní se
+ * s každým novým sestavením programu (podle /proc/self/exe)
+ * 
+ * @return uint64_t Hash identity
+ */
+uint64_t compilerIdentity();
+
+/**
+ * Načte celý soubor do paměti
+ * 
+ * @param file Soubor
+ * @param len Uloží délku načtených dat
+ * @return char* Obsah souboru (je nutné uvolnit přes free())
+ */
+char *readAll(FILE *file, size_t *len);
+
+/**
+ * Zapíše vygenerovaný kód do výstupu. Do souboru se výstup zapisuje po blocích,
+ * pokud právě probíhá zachytávání výstupu, zapíše se kód do bufferu
+ * 
+ * @param data Kód k zapsání
+ * @param len Délka kódu
+ */
+void outWrite(const char *data, size_t len);
+
+/**
+ * Zapíše do výstupu řetězec ukončený nulou
+ * 
+ * @param str Řetězec k zapsání
+ */
+void outStr(const char *str);
+
+/**
+ * Zapíše do výstupu celé číslo v desítkové soustavě
+ * 
+ * @param value Číslo k zapsání
+ */
+void outInt(int value);
+
+/**
+ * Zapíše do výstupu instrukci s jedním operandem (např. "POPS LF@x")
+ * 
+ * @param opcode Operační kód instrukce
+ * @param prefix Začátek operandu, např. rámec "LF@" (může být prázdný)
+ * @param operand Zbytek operandu
+ */
+void outInstr(const char *opcode, const char *prefix, const char *operand);
+
+/**
+ * Vypíše vygenerovaný kód. Funguje stejně jako printf, ale výsledek
+ * zapíše přes outWrite. Pro kód bez formátování je rychlejší outStr
+ * 
+ * @param format Formátovací řetězec (stejný jako u printf)
+ * @param ... Hodnoty pro formátovací řetězec
+ */
+void outPrintf(const char *format, ...);
+
+/**
+ * Nastaví výstup vygenerovaného kódu (volá se na začátku překladu)
+ * 
+ * @param file Soubor pro výstup kódu
+ */
+void outInit(FILE *file);
+
+/**
+ * Zapíše zbytek bufferu výstupu do souboru (volá se na konci překladu)
+ */
+void outFlush();
+
+/**
+ * Zahodí nedokončená zachytávání výstupu (po chybě překladu)
+ */
+void outDispose();
+
+/**
+ * Zahájí zachytávání vygenerovaného kódu do nového bufferu. Zachytávání
+ * lze zanořovat, vnitřní buffer se po ukončení vrací volajícímu
+ */
+void outCaptureStart();
+
+/**
+ * Ukončí nejvnitřnější zachytávání výstupu
+ * 
+ * @return char* Zachycený kód (je nutné uvolnit přes free())
+ */
+char *outCaptureEnd();
+
 /**
  * Konvertuje řetězec ve zdrojovém kódu na řetězec interpretu
  * 
@@ -106,7 +257,12 @@ char *varToInterpret(char *id);
 char *funcToInterpret(char *id);
 
 /**
- * Vygeneruje na standartní výstup hlavičku kódu interpretu, která obsahuje základní 
- * funkce na kontrolu typů a vestavěné funkce jazyka IFJ18
+ * Vygeneruje na standartní výstup hlavičku kódu interpretu s globálními proměnnými
  */
 void generateBaseCode();
+
+/**
+ * Vygeneruje základní funkce na kontrolu typů a vestavěné funkce jazyka IFJ18,
+ * vypisují se za kód programu (hlavní tělo končí instrukcí EXIT)
+ */
+void generateBaseFunctions();
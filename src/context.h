@@ -0,0 +1,40 @@
+/**
+ * @file context.h
+ * 
+ * Kontext překladače - veškerý stav jednoho překladu
+ * 
+ * IFJ Projekt 2018, Tým 13
+ * 
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+#pragma once
+#include "ifj18.h"
+#include "common.h"
+#include "scanner.h"
+#include "codegen.h"
+#include "incremental.h"
+#include "timing.h"
+#include "emitstats.h"
+
+/**
+ * Kontext překladače
+ */
+struct Compiler{
+	tOptions options;		//!< Nastavení překladače
+	FILE *errors;			//!< Výpis chyb a statistik překladu
+	tOutState out;			//!< Výstup vygenerovaného kódu
+	tScanState scanner;		//!< Pozice lexikálního analyzátoru ve vstupu
+	struct cGenState code;	//!< Stav generátoru kódu
+	tIncrState incremental;	//!< Otisky funkcí pro znovupoužití jejich kódu
+	tTiming timing;			//!< Doba jednotlivých fází překladu
+	tEmitStats emitStats;	//!< Počty vygenerovaných instrukcí
+};
+
+/**
+ * Kontext právě probíhajícího překladu v tomto vlákně (nastavuje ifj18_compile)
+ */
+extern __thread pCompiler ctx;
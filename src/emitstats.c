@@ -0,0 +1,178 @@
+/**
+ * @file emitstats.c
+ *
+ * Statická statistika vygenerovaného kódu (--emit-stats)
+ *
+ * IFJ Projekt 2018, Tým 13
+ *
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+#include "emitstats.h"
+#include "context.h"
+
+/**
+ * Počáteční velikost tabulky počtů (při zaplnění se zdvojnásobí)
+ */
+#define EMIT_TABLE_CHUNK 32
+
+/**
+ * Instrukce pracující s datovým zásobníkem
+ */
+static const char *emitStackOps[] = {
+	"PUSHS", "POPS", "CLEARS", "ADDS", "SUBS", "MULS", "DIVS", "IDIVS",
+	"LTS", "GTS", "EQS", "ANDS", "ORS", "NOTS", "INT2FLOATS", "FLOAT2INTS",
+	"INT2CHARS", "STRI2INTS", "JUMPIFEQS", "JUMPIFNEQS"
+};
+
+/**
+ * Přidá nulový počet na konec tabulky
+ */
+static tEmitCount *emitTableAdd(tEmitTable *table, const char *name){
+	if(table->count == table->size){
+		table->size = table->size > 0 ? table->size * 2 : EMIT_TABLE_CHUNK;
+		table->items = safeRealloc(table->items, table->size * sizeof(tEmitCount));
+	}
+
+	tEmitCount *item = &table->items[table->count++];
+	memset(item, 0, sizeof(tEmitCount));
+	item->name = safeMalloc(strlen(name) + 1);
+	strcpy(item->name, name);
+	return item;
+}
+
+/**
+ * Najde počet podle jména, případně ho přidá na konec tabulky
+ */
+static tEmitCount *emitTableGet(tEmitTable *table, const char *name){
+	for(unsigned i = 0; i < table->count; i++)
+		if(strcmp(table->items[i].name, name) == 0) return &table->items[i];
+	return emitTableAdd(table, name);
+}
+
+static void emitTableDispose(tEmitTable *table){
+	for(unsigned i = 0; i < table->count; i++) free(table->items[i].name);
+	free(table->items);
+	memset(table, 0, sizeof(tEmitTable));
+}
+
+/**
+ * Přepne aktuální funkci podle návěští. Funkci začíná návěští bez '$'
+ * (uživatelské a vestavěné funkce), $main$... (hlavní tělo) a $jméno
+ * (pomocná funkce). Ostatní návěští (jméno$tail, $x$...) patří do aktuální
+ * funkce, v pomocných funkcích $x$... jen pokud x je jméno té funkce
+ * (např. $checkIfNum$end, ale ne $length$error)
+ */
+static void emitStatsLabel(const char *label){
+	tEmitTable *functions = &ctx->emitStats.functions;
+	const char *current = functions->count > 0 ? functions->items[functions->count - 1].name : "";
+	const char *name = label;
+
+	if(strncmp(label, "$main$", 6) == 0){
+		name = "$main";
+	}else if(label[0] != '$' && strchr(label, '$') != NULL){
+		return;
+	}else if(label[0] == '$' && strchr(label + 1, '$') != NULL){
+		size_t prefix = strchr(label + 1, '$') - label;
+		bool helper = current[0] == '$' && strcmp(current, "$main") != 0;
+		if(!helper || (strlen(current) == prefix && strncmp(current, label, prefix) == 0)) return;
+	}
+
+	if(strcmp(current, name) != 0) emitTableAdd(functions, name);
+}
+
+/**
+ * Započítá jeden řádek kódu (komentáře, prázdné řádky a hlavička se přeskočí)
+ */
+static void emitStatsLine(char *line){
+	tEmitStats *stats = &ctx->emitStats;
+
+	char *opcode = strtok(line, " \t");
+	if(opcode == NULL || opcode[0] == '#' || opcode[0] == '.') return;
+	char *operand = strtok(NULL, " \t");
+
+	if(strcmp(opcode, "LABEL") == 0 && operand != NULL) emitStatsLabel(operand);
+	// Kód před prvním návěštím patří hlavnímu tělu
+	if(stats->functions.count == 0) emitTableAdd(&stats->functions, "$main");
+
+	bool metrics[EMIT_METRIC_COUNT] = { [EMIT_INSTRUCTIONS] = true };
+	if(strcmp(opcode, "CALL") == 0 && operand != NULL && operand[0] == '$'){
+		metrics[EMIT_HELPER_CALLS] = true;
+		emitTableGet(&stats->helpers, operand)->count[0]++;
+	}
+	metrics[EMIT_FRAMES] = strcmp(opcode, "CREATEFRAME") == 0;
+	for(size_t i = 0; i < sizeof(emitStackOps) / sizeof(emitStackOps[0]); i++)
+		if(strcmp(opcode, emitStackOps[i]) == 0) metrics[EMIT_STACK] = true;
+
+	tEmitCount *function = &stats->functions.items[stats->functions.count - 1];
+	for(int i = 0; i < EMIT_METRIC_COUNT; i++){
+		function->count[i] += metrics[i];
+		stats->total[i] += metrics[i];
+	}
+	emitTableGet(&stats->opcodes, opcode)->count[0]++;
+}
+
+void emitStatsInit(){
+	memset(&ctx->emitStats, 0, sizeof(tEmitStats));
+}
+
+void emitStatsFeed(const char *data, size_t len){
+	if(!ctx->options.emitStats) return;
+	tEmitStats *stats = &ctx->emitStats;
+
+	for(size_t i = 0; i < len; i++){
+		if(data[i] == EOL){
+			stats->line[stats->lineLen] = '\0';
+			emitStatsLine(stats->line);
+			stats->lineLen = 0;
+		}else if(stats->lineLen < EMIT_LINE_SIZE - 1){
+			stats->line[stats->lineLen++] = data[i];
+		}
+	}
+}
+
+/**
+ * Řazení podle počtu sestupně, při shodě podle jména
+ */
+static int emitCompare(const void *a, const void *b){
+	const tEmitCount *x = a;
+	const tEmitCount *y = b;
+	if(x->count[0] != y->count[0]) return x->count[0] < y->count[0] ? 1 : -1;
+	return strcmp(x->name, y->name);
+}
+
+void emitStatsReport(){
+	if(!ctx->options.emitStats) return;
+	tEmitStats *stats = &ctx->emitStats;
+	FILE *out = ctx->errors;
+
+	// Poslední řádek bez konce řádku
+	if(stats->lineLen > 0) emitStatsFeed("\n", 1);
+
+	fprintf(out, "[EMIT] %-8s %-24s %8s %8s %8s %8s\n", "", "", "instrs", "helpers", "frames", "stack");
+	for(unsigned i = 0; i < stats->functions.count; i++){
+		tEmitCount *function = &stats->functions.items[i];
+		fprintf(out, "[EMIT] function %-24s %8lu %8lu %8lu %8lu\n", function->name,
+			function->count[EMIT_INSTRUCTIONS], function->count[EMIT_HELPER_CALLS],
+			function->count[EMIT_FRAMES], function->count[EMIT_STACK]);
+	}
+	fprintf(out, "[EMIT] total    %-24s %8lu %8lu %8lu %8lu\n", "", stats->total[EMIT_INSTRUCTIONS],
+		stats->total[EMIT_HELPER_CALLS], stats->total[EMIT_FRAMES], stats->total[EMIT_STACK]);
+
+	qsort(stats->opcodes.items, stats->opcodes.count, sizeof(tEmitCount), emitCompare);
+	for(unsigned i = 0; i < stats->opcodes.count; i++)
+		fprintf(out, "[EMIT] opcode   %-24s %8lu\n", stats->opcodes.items[i].name, stats->opcodes.items[i].count[0]);
+
+	qsort(stats->helpers.items, stats->helpers.count, sizeof(tEmitCount), emitCompare);
+	for(unsigned i = 0; i < stats->helpers.count; i++)
+		fprintf(out, "[EMIT] helper   %-24s %8lu\n", stats->helpers.items[i].name, stats->helpers.items[i].count[0]);
+}
+
+void emitStatsDispose(){
+	emitTableDispose(&ctx->emitStats.functions);
+	emitTableDispose(&ctx->emitStats.opcodes);
+	emitTableDispose(&ctx->emitStats.helpers);
+}
@@ -0,0 +1,90 @@
+/**
+ * @file emitstats.h
+ *
+ * Statická statistika vygenerovaného kódu (--emit-stats)
+ *
+ * Počítá instrukce IFJcode18 zapsané do výstupu podle operačního kódu
+ * a podle funkce, ve které jsou. U každé funkce zvlášť počítá i drahé
+ * instrukce: volání pomocných funkcí pro kontrolu typů ($checkIfAdd apod.),
+ * CREATEFRAME a operace s datovým zásobníkem. Jde o počty instrukcí v kódu,
+ * ne o počty provedených instrukcí.
+ *
+ * IFJ Projekt 2018, Tým 13
+ *
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+#pragma once
+#include <stddef.h>
+
+/**
+ * Délka začátku řádku, ze kterého se čte instrukce a první operand (zbytek se zahodí)
+ */
+#define EMIT_LINE_SIZE 128
+
+/**
+ * Sledované počty u každé funkce
+ */
+typedef enum{
+	EMIT_INSTRUCTIONS,	//!< Všechny instrukce
+	EMIT_HELPER_CALLS,	//!< CALL pomocných funkcí ($checkIfAdd, $promote, ...)
+	EMIT_FRAMES,		//!< CREATEFRAME
+	EMIT_STACK,			//!< Operace s datovým zásobníkem (PUSHS, POPS, ADDS, ...)
+	EMIT_METRIC_COUNT
+} tEmitMetric;
+
+/**
+ * Pojmenovaný počet (funkce, operační kód nebo pomocná funkce)
+ */
+typedef struct EmitCount{
+	char *name;
+	unsigned long count[EMIT_METRIC_COUNT];	//!< Operační kódy a pomocné funkce používají jen první počet
+} tEmitCount;
+
+/**
+ * Tabulka pojmenovaných počtů (v pořadí prvního výskytu)
+ */
+typedef struct EmitTable{
+	tEmitCount *items;
+	unsigned count;
+	unsigned size;
+} tEmitTable;
+
+/**
+ * Statistika vygenerovaného kódu (součást kontextu překladače)
+ */
+typedef struct EmitStats{
+	char line[EMIT_LINE_SIZE];	//!< Začátek rozpracovaného řádku výstupu
+	size_t lineLen;				//!< Délka uloženého začátku řádku
+	tEmitTable functions;		//!< Funkce ($main = hlavní tělo, $jméno = pomocná funkce)
+	tEmitTable opcodes;			//!< Operační kódy
+	tEmitTable helpers;			//!< Volané pomocné funkce
+	unsigned long total[EMIT_METRIC_COUNT];	//!< Součet přes všechny funkce
+} tEmitStats;
+
+/**
+ * Vynuluje statistiku (volá se na začátku překladu)
+ */
+void emitStatsInit();
+
+/**
+ * Započítá kus vygenerovaného kódu (volá se pro vše, co se zapisuje do výstupu).
+ * Řádky mohou být rozdělené mezi více volání
+ *
+ * @param data Kód
+ * @param len Délka kódu
+ */
+void emitStatsFeed(const char *data, size_t len);
+
+/**
+ * Vypíše statistiku do výpisu chyb (jen s --emit-stats)
+ */
+void emitStatsReport();
+
+/**
+ * Uvolní tabulky statistiky (volá se na konci překladu)
+ */
+void emitStatsDispose();
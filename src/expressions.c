@@ -12,6 +12,8 @@
  */
 
 #include "expressions.h"
+#include "codegen.h"
+#include "context.h"
 
 eRelTerm exprConvTypeToTerm(tType tokenType){
 	switch(tokenType){
@@ -102,7 +104,7 @@ eRelation exprGetRelation(eRelTerm currTerm, eRelTerm newTerm){
 }
 
 int exprParse(pToken *token, psTree idTable){
-	printf("CLEARS\n");
+	outStr("CLEARS\n");
 	peStack stack;
 	exprStackInit(&stack);
 
@@ -123,6 +125,7 @@ int exprParse(pToken *token, psTree idTable){
 				item = safeMalloc(sizeof(struct eItem));
 				item->type = IT_TERM;
 				item->val.term = *token;
+				item->id = NULL;
 
 				exprStackPush(stack, item);
 				*token = (*token)->nextToken;
@@ -140,6 +143,7 @@ int exprParse(pToken *token, psTree idTable){
 				item = safeMalloc(sizeof(struct eItem));
 				item->type = IT_TERM;
 				item->val.term = *token;
+				item->id = NULL;
 
 				exprStackPush(stack, item);
 				*token = (*token)->nextToken;
@@ -147,23 +151,23 @@ int exprParse(pToken *token, psTree idTable){
 			case E_EMPTY:
 				if(stackT == newT && stackT == E_$){
 					if(stack->top < 0){
-						fprintf(stderr, "[SYNTAX] Error on line %d:%d - Expression cannot be empty\n", (*token)->linePos, (*token)->colPos);
+						fprintf(ctx->errors, "[SYNTAX] Error on line %d:%d - Expression cannot be empty\n", (*token)->linePos, (*token)->colPos);
 						retCode = 2;
 					}else {
-						printf("CREATEFRAME\nDEFVAR TF@$return\nPOPS TF@$return\n");
+						// Výsledek zůstává na zásobníku, uloží ho generátor kódu podle kontextu
 						retCode = 0;
 					}
 					
 				}else{
-					fprintf(stderr, "[SYNTAX] Error on line %d:%d - ", (*token)->linePos, (*token)->colPos);
+					fprintf(ctx->errors, "[SYNTAX] Error on line %d:%d - ", (*token)->linePos, (*token)->colPos);
 					
 					if(termPos < 0)
 						if((*token)->type == T_RBRCKT)
-							fprintf(stderr, "Found extra right bracket in expression\n");
+							fprintf(ctx->errors, "Found extra right bracket in expression\n");
 						else
-							fprintf(stderr, "Expression cannot start with %s\n", scannerTypeToString((*token)->type));
+							fprintf(ctx->errors, "Expression cannot start with %s\n", scannerTypeToString((*token)->type));
 					else 
-						fprintf(stderr, "%s in expression cannot be followed with %s\n",
+						fprintf(ctx->errors, "%s in expression cannot be followed with %s\n",
 							scannerTypeToString(stack->s[termPos]->val.term->type),
 							scannerTypeToString((*token)->type));
 					retCode = 2;
@@ -229,6 +233,7 @@ void exprStackInsertOpen(peStack stack, int pos){
 
 	peItem item = safeMalloc(sizeof(struct eItem));
 	item->type = IT_OPEN;
+	item->id = NULL;
 	stack->s[pos] = item;
 }
 
@@ -244,51 +249,43 @@ int exprStackParse(peStack stack, psTree idTable){
 		}else{
 			// Pravidlo <expr> => <val>
 			eTermType ttype = E_UNKNOWN;
-			char *out;
 			switch(item->val.term->type){
 				case T_INTEGER: 
-					out = intToInterpret(item->val.term->data);
 					ttype = E_INT;
 					break;
 				case T_FLOAT: 
-					out = floatToInterpret(item->val.term->data);
 					ttype = E_FLOAT; 
 					break;
 				case T_STRING: 
-					out = stringToInterpret(item->val.term->data);
 					ttype = E_STRING;
 					break;
 				case T_NIL: 
-					out = nilToInterpret();
 					ttype = E_NIL;
 					break;
 				case T_TRUE:
-					out = trueToInterpret();
-					ttype = E_BOOL; 
-					break;
 				case T_FALSE:
-					out = falseToInterpret();
 					ttype = E_BOOL; 
 					break;
 				case T_ID:
 					if(symTabSearch(&idTable, item->val.term->data) == NULL){
 						// Proměnná není definovaná
-						fprintf(stderr, "[SEMANTIC] Error on line %d:%d - Variable \"%s\" in expression is not defined\n", item->val.term->linePos, item->val.term->colPos, item->val.term->data);
+						fprintf(ctx->errors, "[SEMANTIC] Error on line %d:%d - Variable \"%s\" in expression is not defined\n", item->val.term->linePos, item->val.term->colPos, item->val.term->data);
 						free(item);
 						return 3; // Chyba
 					}
-					out = varToInterpret(item->val.term->data);
 					break;
 				default: 
-					fprintf(stderr, "[SYNTAX] Error on line %d:%d - Exprected operand, found %s\n",
+					fprintf(ctx->errors, "[SYNTAX] Error on line %d:%d - Exprected operand, found %s\n",
 						item->val.term->linePos,
 						item->val.term->colPos,
 						scannerTypeToString(item->val.term->type));
 					free(item);
 					return 2;
 			}
-			printf("PUSHS %s\n", out);
-			free(out);
+			// Proměnná se zapíše přímo bez převodu
+			if(item->val.term->type == T_ID) outInstr("PUSHS", "LF@", item->val.term->data);
+			else outInstr("PUSHS", "", codeLiteral(item->val.term));
+			item->id = item->val.term->type == T_ID ? item->val.term : NULL;
 			item->type = IT_NONTERM;
 			item->val.type = ttype;
 		}
@@ -308,20 +305,22 @@ int exprStackParse(peStack stack, psTree idTable){
 	bool isSingle = lItem->type == IT_OPEN;
 	bool hasUnknown = rType == E_UNKNOWN;
 	bool isSame = false;
+	eTermType knownType = E_UNKNOWN;
 	
 	// Sémantická část
 	if(!isSingle){
 		hasUnknown = lType == E_UNKNOWN || rType == E_UNKNOWN;
+		if(hasUnknown && lType != rType) knownType = lType == E_UNKNOWN ? rType : lType;
 		
 		if(lType == rType){
 			isSame = true;
 		}else if(lType == E_INT && rType == E_FLOAT){
-			printf("POPS GF@$tmp\n");
-			printf("INT2FLOATS\n");
-			printf("PUSHS GF@$tmp\n");
+			outStr("POPS GF@$tmp\n");
+			outStr("INT2FLOATS\n");
+			outStr("PUSHS GF@$tmp\n");
 			isSame = true;
 		}else if(lType == E_FLOAT && rType == E_INT){
-			printf("INT2FLOATS\n");
+			outStr("INT2FLOATS\n");
 			type = E_FLOAT;
 			isSame = true;
 		}else if(rType == E_UNKNOWN){
@@ -335,10 +334,15 @@ int exprStackParse(peStack stack, psTree idTable){
 	switch(item->val.term->type){
 		case T_ADD:
 			if(isSingle){
-				if(type == E_FLOAT) printf("PUSHS float@0x0p+0\n");
-				else printf("PUSHS int@0\n");
+				if(type == E_FLOAT) outStr("PUSHS float@0x0p+0\n");
+				else outStr("PUSHS int@0\n");
+			}
+			if(hasUnknown){
+				if(knownType == E_STRING)
+					exprCheckTypes("$checkIfAdd", "POPS GF@$tmp2\nPOPS GF@$tmp\nCONCAT GF@$tmp GF@$tmp GF@$tmp2\nPUSHS GF@$tmp\n", lItem, rItem, knownType);
+				else
+					exprCheckTypes("$checkIfAdd", "ADDS\n", lItem, rItem, knownType);
 			}
-			if(hasUnknown) printf("CALL $checkIfAdd\n");
 			if((!isSingle && !isSame) || (type != E_INT && type != E_FLOAT && type != E_STRING && type != E_UNKNOWN)){
 				exprSPPrintError(4, isSingle, isSame, lType, rType, item->val.term);
 				free(item);
@@ -349,12 +353,12 @@ int exprStackParse(peStack stack, psTree idTable){
 			break;
 		case T_SUB:
 			if(isSingle){
-				printf("POPS GF@$tmp\n");
-				if(type == E_FLOAT) printf("PUSHS float@0x0p+0\n");
-				else printf("PUSHS int@0\n");
-				printf("PUSHS GF@$tmp\n");
+				outStr("POPS GF@$tmp\n");
+				if(type == E_FLOAT) outStr("PUSHS float@0x0p+0\n");
+				else outStr("PUSHS int@0\n");
+				outStr("PUSHS GF@$tmp\n");
 			}
-			if(hasUnknown) printf("CALL $checkIfNum\n");
+			if(hasUnknown) exprCheckTypes("$checkIfNum", NULL, lItem, rItem, knownType);
 			if((!isSingle && !isSame) || (type != E_INT && type != E_FLOAT && type != E_UNKNOWN)){
 				exprSPPrintError(4, isSingle, isSame, lType, rType, item->val.term);
 				free(item);
@@ -364,7 +368,7 @@ int exprStackParse(peStack stack, psTree idTable){
 			}
 			break;
 		case T_MUL:
-			if(hasUnknown) printf("CALL $checkIfNum\n");
+			if(hasUnknown) exprCheckTypes("$checkIfNum", NULL, lItem, rItem, knownType);
 			if(!isSame || (type != E_INT && type != E_FLOAT && type != E_UNKNOWN)){
 				exprSPPrintError(isSingle? 2 : 4, isSingle, isSame, lType, rType, item->val.term);
 				free(item);
@@ -374,7 +378,7 @@ int exprStackParse(peStack stack, psTree idTable){
 			}
 			break;
 		case T_DIV:
-			if(hasUnknown) printf("CALL $checkIfNum\n");
+			if(hasUnknown) exprCheckTypes("$checkIfNum", NULL, lItem, rItem, knownType);
 			if(!isSame || (type != E_INT && type != E_FLOAT && type != E_UNKNOWN)){
 				exprSPPrintError(isSingle? 2 : 4, isSingle, isSame, lType, rType, item->val.term);
 				free(item);
@@ -387,7 +391,7 @@ int exprStackParse(peStack stack, psTree idTable){
 		case T_LTE:
 		case T_GT:
 		case T_GTE:
-			if(hasUnknown) printf("CALL $checkIfLtGt\n");
+			if(hasUnknown) exprCheckTypes("$checkIfLtGt", NULL, lItem, rItem, knownType);
 			if(!isSame || (type != E_FLOAT && type != E_INT && type != E_UNKNOWN && type != E_STRING)){
 				exprSPPrintError(isSingle? 2 : 4, isSingle, isSame, lType, rType, item->val.term);
 				free(item);
@@ -404,14 +408,14 @@ int exprStackParse(peStack stack, psTree idTable){
 				free(rItem);
 				free(lItem);
 				return 2; // Error
-			}else if(hasUnknown) printf("CALL $checkIfEql\n");
-			else if(!isSame) printf("POPS GF@$tmp\nPOPS GF@$tmp\nPUSHS bool@false\n");
+			}else if(hasUnknown) exprCheckTypes("$checkIfEql", NULL, lItem, rItem, knownType);
+			else if(!isSame) outStr("POPS GF@$tmp\nPOPS GF@$tmp\nPUSHS bool@false\n");
 			break;
 		case T_NOT:
-			if(hasUnknown){
-				printf("PUSHS bool@false\n");
-				printf("CALL $checkIfBool\n");
-				printf("POPS GF@$tmp\n");
+			if(hasUnknown && !ctx->options.unchecked){
+				outStr("PUSHS bool@false\n");
+				outStr("CALL $checkIfBool\n");
+				outStr("POPS GF@$tmp\n");
 			}
 			if(!isSingle || (type != E_BOOL && type != E_UNKNOWN)){
 				exprSPPrintError(!isSingle? 2 : 4, isSingle, isSame, lType, rType, item->val.term);
@@ -423,7 +427,7 @@ int exprStackParse(peStack stack, psTree idTable){
 			break;
 		case T_AND:
 		case T_OR:
-			if(hasUnknown) printf("CALL $checkIfBool\n");
+			if(hasUnknown) exprCheckTypes("$checkIfBool", NULL, lItem, rItem, knownType);
 			if(!isSame || (type != E_BOOL && type != E_UNKNOWN)){
 				exprSPPrintError(isSingle? 2 : 4, isSingle, isSame, lType, rType, item->val.term);
 				free(item);
@@ -433,7 +437,7 @@ int exprStackParse(peStack stack, psTree idTable){
 			}
 			break;
 		default:
-			fprintf(stderr, "[INTERNAL] Error on line %d:%d - Got unexpected operator in expression (%s)\n", 
+			fprintf(ctx->errors, "[INTERNAL] Error on line %d:%d - Got unexpected operator in expression (%s)\n", 
 				item->val.term->linePos,
 				item->val.term->colPos,
 				scannerTypeToString(item->val.term->type)
@@ -449,25 +453,25 @@ int exprStackParse(peStack stack, psTree idTable){
 		case T_ADD:
 			if(!hasUnknown){
 				if(type == E_STRING)
-					printf("POPS GF@$tmp2\nPOPS GF@$tmp\nCONCAT GF@$tmp GF@$tmp GF@$tmp2\nPUSHS GF@$tmp\n");
+					outStr("POPS GF@$tmp2\nPOPS GF@$tmp\nCONCAT GF@$tmp GF@$tmp GF@$tmp2\nPUSHS GF@$tmp\n");
 				else
-					printf("ADDS\n");
+					outStr("ADDS\n");
 			}
 			break;
 		case T_SUB:
-			printf("SUBS\n");
+			outStr("SUBS\n");
 			break;
 		case T_MUL:
-			printf("MULS\n");
+			outStr("MULS\n");
 			break;
 		case T_DIV:
-			printf("CALL $checkDivByZero\n");
+			if(!ctx->options.unchecked) outStr("CALL $checkDivByZero\n");
 			if(hasUnknown){
-				printf("CALL $decideDivOp\n");
+				outStr("CALL $decideDivOp\n");
 			}else if(type == E_FLOAT){
-				printf("DIVS\n");
+				outStr("DIVS\n");
 			}else if(type == E_INT){
-				printf("IDIVS\n");
+				outStr("IDIVS\n");
 			}else{
 				free(item);
 				free(rItem);
@@ -476,40 +480,40 @@ int exprStackParse(peStack stack, psTree idTable){
 			}
 			break;
 		case T_GTE:
-			printf("LTS\nNOTS\n");
+			outStr("LTS\nNOTS\n");
 			type = E_BOOL;
 			break;
 		case T_LT:
-			printf("LTS\n");
+			outStr("LTS\n");
 			type = E_BOOL;
 			break;
 		case T_LTE:
-			printf("GTS\nNOTS\n");
+			outStr("GTS\nNOTS\n");
 			type = E_BOOL;
 			break;
 		case T_GT:
-			printf("GTS\n");
+			outStr("GTS\n");
 			type = E_BOOL;
 			break;
 		case T_EQL:
-			if(isSame) printf("EQS\n");
+			if(isSame) outStr("EQS\n");
 			type = E_BOOL;
 			break;
 		case T_NEQ:
-			if(isSame) printf("EQS\n");
-			printf("NOTS\n");
+			if(isSame) outStr("EQS\n");
+			outStr("NOTS\n");
 			type = E_BOOL;
 			break;
 		case T_NOT:
-			printf("NOTS\n");
+			outStr("NOTS\n");
 			type = E_BOOL;
 			break;
 		case T_AND:
-			printf("ANDS\n");
+			outStr("ANDS\n");
 			type = E_BOOL;
 			break;
 		case T_OR:
-			printf("ORS\n");
+			outStr("ORS\n");
 			type = E_BOOL;
 			break;
 		default:
@@ -519,16 +523,70 @@ int exprStackParse(peStack stack, psTree idTable){
 			return 99; // Return
 	}
 
+	// Celé číslo s neznámým operandem se za běhu může převést na desetinné,
+	// typ výsledku proto není znám (jinak by další operace vynechala kontrolu)
+	if(hasUnknown && type == E_INT) type = E_UNKNOWN;
+
 	free(lItem);
 	free(rItem);
 	item->type = IT_NONTERM;
 	item->val.type = type;
+	item->id = NULL;
 	if(!isSingle) free(exprStackPop(stack));
 	exprStackPush(stack, item);
 
 	return 0;
 }
 
+void exprCheckTypes(const char *helper, const char *op, peItem lItem, peItem rItem, eTermType type){
+	const char *fastJump;
+
+	// Důvěryhodný kód: bool a řetězec se nepřevádí na jiný typ, kontrola není potřeba
+	// (porovnání na rovnost ale pro různé typy vrací false)
+	if(ctx->options.unchecked && (strcmp(helper, "$checkIfBool") == 0 ||
+		(type == E_STRING && strcmp(helper, "$checkIfEql") != 0))){
+		if(op != NULL) outStr(op);
+		return;
+	}
+
+	switch(type){
+		case E_INT: fastJump = "$fast GF@$lt string@int"; break;
+		case E_FLOAT: fastJump = "$fast GF@$lt string@float"; break;
+		case E_STRING: fastJump = "$fast GF@$lt string@string"; break;
+		case E_NIL: fastJump = "$fast GF@$lt string@nil"; break;
+		case E_BOOL: fastJump = "$fast GF@$lt string@bool"; break;
+		default:
+			// Oba operandy jsou neznámé -> vše zkontroluje pomocná funkce
+			outInstr("CALL", "", helper);
+			return;
+	}
+
+	// Typ neznámého operandu (proměnná se otestuje přímo, jinak přes zásobník)
+	peItem unknown = lItem->val.type == E_UNKNOWN ? lItem : rItem;
+	if(unknown->id != NULL){
+		outStr("TYPE GF@$lt LF@");
+		outStr(unknown->id->data);
+		outWrite("\n", 1);
+	}else if(unknown == rItem){
+		outStr("POPS GF@$rv\nTYPE GF@$lt GF@$rv\nPUSHS GF@$rv\n");
+	}else{
+		outStr("POPS GF@$rv\nPOPS GF@$lv\nTYPE GF@$lt GF@$lv\nPUSHS GF@$lv\nPUSHS GF@$rv\n");
+	}
+
+	// Při shodě typů se přeskočí volání pomocné funkce
+	codeLabel("JUMPIFEQ", "$check$", ctx->code.labels.checkCounter, fastJump);
+	outInstr("CALL", "", helper);
+	if(op != NULL){
+		codeLabel("JUMP", "$check$", ctx->code.labels.checkCounter, "$end");
+		codeLabel("LABEL", "$check$", ctx->code.labels.checkCounter, "$fast");
+		outStr(op);
+		codeLabel("LABEL", "$check$", ctx->code.labels.checkCounter, "$end");
+	}else{
+		codeLabel("LABEL", "$check$", ctx->code.labels.checkCounter, "$fast");
+	}
+	ctx->code.labels.checkCounter++;
+}
+
 const char *exprTermTypeToString(eTermType type){
 	switch (type)
 	{
@@ -544,25 +602,25 @@ const char *exprTermTypeToString(eTermType type){
 }
 
 void exprSPPrintError(int etype, bool isSingle, bool isSame, eTermType lt, eTermType rt, pToken op){
-	if(etype == 4) fprintf(stderr, "[SEMANTIC]");
-	else fprintf(stderr, "[SYNTAX]");
-	fprintf(stderr, " Error on line %d:%d - ", op->linePos, op->colPos);
-	if(etype == 4) fprintf(stderr, "Type error; ");
-	fprintf(stderr, "(Operation %s) ", scannerTypeToString(op->type));
+	if(etype == 4) fprintf(ctx->errors, "[SEMANTIC]");
+	else fprintf(ctx->errors, "[SYNTAX]");
+	fprintf(ctx->errors, " Error on line %d:%d - ", op->linePos, op->colPos);
+	if(etype == 4) fprintf(ctx->errors, "Type error; ");
+	fprintf(ctx->errors, "(Operation %s) ", scannerTypeToString(op->type));
 	if(op->type != T_NOT){
 		if(isSingle){
-			fprintf(stderr, "Missing left operand");
+			fprintf(ctx->errors, "Missing left operand");
 		}else if(!isSame){
-			fprintf(stderr, "Operands are not the same type (left: %s, right: %s)", 
+			fprintf(ctx->errors, "Operands are not the same type (left: %s, right: %s)", 
 				exprTermTypeToString(lt),
 				exprTermTypeToString(rt)
 				);
 		}else{
-			fprintf(stderr, "Incopatible types %s", exprTermTypeToString(lt == E_UNKNOWN ? rt : lt));
+			fprintf(ctx->errors, "Incopatible types %s", exprTermTypeToString(lt == E_UNKNOWN ? rt : lt));
 		}
 	}else{
-		fprintf(stderr, "Operand type %s is not compatible with this operation", exprTermTypeToString(rt));
+		fprintf(ctx->errors, "Operand type %s is not compatible with this operation", exprTermTypeToString(rt));
 	}
 	
-	fprintf(stderr, "\n");
+	fprintf(ctx->errors, "\n");
 }
\ No newline at end of file
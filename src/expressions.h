@@ -83,6 +83,7 @@ typedef union{
 typedef struct eItem{
 	eItemType type;	//!< Typ položky
 	eItemVal val;	//!< Hodnota
+	pToken id;	//!< Token proměnné, pokud je neterminál přímo její hodnotou (jinak NULL)
 } *peItem;
 
 /**
@@ -179,6 +180,20 @@ void exprStackInsertOpen(peStack stack, int pos);
  */
 int exprStackParse(peStack stack, psTree idTable);
 
+/**
+ * Vygeneruje běhovou kontrolu typů operandů voláním pomocné funkce.
+ * Je-li typ jednoho operandu známý, otestuje se typ druhého přímo
+ * a pomocná funkce se volá jen při neshodě typů. S volbou --unchecked se kontrola
+ * vynechá úplně, pokud by nemohla vést k převodu typu
+ * 
+ * @param helper Návěští pomocné funkce ($checkIf...)
+ * @param op Kód operace pro rychlou cestu, pokud ji pomocná funkce provádí sama (jinak NULL)
+ * @param lItem Levý operand
+ * @param rItem Pravý operand
+ * @param type Známý typ jednoho z operandů (E_UNKNOWN pokud žádný)
+ */
+void exprCheckTypes(const char *helper, const char *op, peItem lItem, peItem rItem, eTermType type);
+
 /**
  * Vrátí řetězec reprezentující typ terminálu (používá se při výpisu chyby)
  * 
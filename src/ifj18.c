@@ -0,0 +1,93 @@
+/**
+ * @file ifj18.c
+ * 
+ * Rozhraní překladače jako knihovny (libifj18.a)
+ * 
+ * IFJ Projekt 2018, Tým 13
+ * 
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+// fmemopen() je součástí POSIX
+#define _POSIX_C_SOURCE 200809L
+#include "context.h"
+#include "parser.h"
+
+__thread pCompiler ctx = NULL;
+
+pCompiler ifj18_create(const tOptions *options){
+	pCompiler compiler = safeMalloc(sizeof(struct Compiler));
+	memset(compiler, 0, sizeof(struct Compiler));
+	if(options != NULL) compiler->options = *options;
+	compiler->errors = stderr;
+	return compiler;
+}
+
+void ifj18_set_errors(pCompiler compiler, FILE *errors){
+	compiler->errors = errors;
+}
+
+int ifj18_compile(pCompiler compiler, FILE *input, FILE *output){
+	pCompiler outer = ctx;
+	ctx = compiler;
+
+	outInit(output);
+	scannerInit();
+	codeInit();
+	timingInit();
+	emitStatsInit();
+
+	// Při měření fází se vstup načte celý předem, jinak se čte během lexikální analýzy
+	char *source = NULL;
+	if(ctx->options.timePhases){
+		timingPhase(PHASE_READ);
+		source = readAll(input, &ctx->timing.bytesIn);
+		input = ctx->timing.bytesIn > 0 ? fmemopen(source, ctx->timing.bytesIn, "r") : fopen("/dev/null", "r");
+		if(input == NULL){
+			fprintf(stderr, "[INTERNAL] Fatal error - cannot open input\n");
+			exit(99);
+		}
+	}
+
+	timingPhase(PHASE_SCAN);
+	pToken token;
+	int retval = scannerGetTokenList(&token, input);
+
+	if(retval == 0){
+		timingPhase(PHASE_PARSE);
+		incrementalInit(token);
+		timingEnter(PHASE_EMIT);
+		generateBaseCode();
+		timingLeave(PHASE_EMIT);
+		retval = parser(&token);
+		timingPhase(PHASE_FLUSH);
+		outFlush();
+		if(retval == 0) emitStatsReport();
+	}
+
+	// Po chybě zůstává v kontextu rozpracovaný stav
+	timingPhase(PHASE_TEARDOWN);
+	codeDispose();
+	incrementalDispose();
+	outDispose();
+	scannerFreeTokenList(&token);
+	timingPhase(PHASE_NONE);
+	timingReport();
+	timingDispose();
+	emitStatsDispose();
+
+	if(source != NULL){
+		fclose(input);
+		free(source);
+	}
+
+	ctx = outer;
+	return retval;
+}
+
+void ifj18_destroy(pCompiler compiler){
+	free(compiler);
+}
@@ -0,0 +1,74 @@
+/**
+ * @file ifj18.h
+ * 
+ * Rozhraní překladače jako knihovny (libifj18.a)
+ * 
+ * Veškerý stav překladu je v kontextu, jeden proces tak může přeložit
+ * libovolný počet programů. Různé kontexty lze používat současně
+ * z různých vláken, jeden kontext vždy jen z jednoho vlákna.
+ * 
+ * IFJ Projekt 2018, Tým 13
+ * 
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+#pragma once
+#include <stdio.h>
+#include <stdbool.h>
+
+/**
+ * Nastavení překladače (z příkazové řádky)
+ */
+typedef struct Options{
+	bool stackCalls;	//!< Argumenty a návratová hodnota uživatelských funkcí se předávají přes datový zásobník
+	bool unchecked;		//!< Důvěryhodný kód: negenerují se běhové kontroly typů a dělení nulou
+	bool literalStats;	//!< Na konci překladu se do výpisu chyb vypíše statistika tabulky literálů
+	const char *incrementalDir;	//!< Složka s kódem funkcí z předchozích překladů (NULL = vše se generuje)
+	bool timePhases;	//!< Na konci překladu se do výpisu chyb vypíše doba jednotlivých fází překladu
+	bool timePhasesJson;	//!< Doba fází se vypíše jako jeden řádek JSON (jen s timePhases)
+	bool perfCounters;	//!< K době fází se vypíšou i hardwarové čítače (jen s timePhases, přes perf_event_open)
+	bool emitStats;		//!< Na konci překladu se do výpisu chyb vypíšou počty vygenerovaných instrukcí
+} tOptions;
+
+/**
+ * Kontext překladače (obsah je skrytý)
+ */
+typedef struct Compiler *pCompiler;
+
+/**
+ * Vytvoří kontext překladače
+ * 
+ * @param options Nastavení překladače (NULL = výchozí)
+ * @return pCompiler Nový kontext
+ */
+pCompiler ifj18_create(const tOptions *options);
+
+/**
+ * Nastaví, kam se vypisují chyby a statistiky překladu (výchozí je stderr)
+ * 
+ * @param compiler Kontext překladače
+ * @param errors Soubor pro výpis chyb
+ */
+void ifj18_set_errors(pCompiler compiler, FILE *errors);
+
+/**
+ * Přeloží program ze vstupu a kód IFJcode18 zapíše na výstup. Kontext
+ * lze použít pro další překlad, každý překlad začíná od začátku
+ * (vygenerovaný kód nezávisí na předchozích překladech)
+ * 
+ * @param compiler Kontext překladače
+ * @param input Zdrojový kód v jazyce IFJ18
+ * @param output Výstup vygenerovaného kódu
+ * @return int Návratový kód překladače (0 = v pořádku, chyby jako u programu compiler)
+ */
+int ifj18_compile(pCompiler compiler, FILE *input, FILE *output);
+
+/**
+ * Uvolní kontext překladače
+ * 
+ * @param compiler Kontext pro uvolnění
+ */
+void ifj18_destroy(pCompiler compiler);
@@ -0,0 +1,246 @@
+/**
+ * @file incremental.c
+ * 
+ * Znovupoužití kódu nezměněných funkcí z předchozích překladů
+ * 
+ * IFJ Projekt 2018, Tým 13
+ * 
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+// getpid() a mkdir() jsou součástí POSIX
+#define _POSIX_C_SOURCE 200809L
+#include "incremental.h"
+#include "context.h"
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Index jména funkce v tabulce jmen
+ */
+static unsigned incrementalNameIndex(const char *id){
+	return (unsigned)hashFnv64(HASH_FNV64_INIT, id, strlen(id)) & (ctx->incremental.namesSize - 1);
+}
+
+/**
+ * Najde definici funkce podle jména
+ */
+static tIncrFunc *incrementalFind(const char *id){
+	for(tIncrFunc *func = ctx->incremental.names[incrementalNameIndex(id)]; func != NULL; func = func->next)
+		if(strcmp(func->id, id) == 0) return func;
+	return NULL;
+}
+
+/**
+ * Sestaví cestu k uloženému kódu funkce
+ * 
+ * @return char* Cesta (je nutné uvolnit přes free())
+ */
+static char *incrementalPath(tIncrFunc *func){
+	const char *dir = ctx->options.incrementalDir;
+	char *path = safeMalloc(strlen(dir) + 16 + sizeof(INCREMENTAL_EXT) + 1);
+	sprintf(path, "%s/%016llx%s", dir, (unsigned long long)func->fingerprint, INCREMENTAL_EXT);
+	return path;
+}
+
+void incrementalInit(pToken token){
+	tIncrState *incr = &ctx->incremental;
+	memset(incr, 0, sizeof(tIncrState));
+	if(ctx->options.incrementalDir == NULL) return;
+
+	// Rozsahy definic funkcí (def, if a while se uzavírají end) a hash jejich tokenů
+	int size = 0;
+	int depth = 0;
+	tIncrFunc *func = NULL;
+	for(; token != NULL; token = token->nextToken){
+		if(token->type == T_DEF && depth == 0){
+			if(incr->funcCount >= size){
+				size = size > 0 ? size * 2 : 16;
+				incr->funcs = safeRealloc(incr->funcs, size * sizeof(tIncrFunc));
+			}
+			func = &incr->funcs[incr->funcCount++];
+			func->id = token->nextToken != NULL && token->nextToken->type == T_ID ? token->nextToken->data : "";
+			func->def = token;
+			func->end = NULL;
+			func->hash = HASH_FNV64_INIT;
+		}
+
+		if(token->type == T_DEF || token->type == T_IF || token->type == T_WHILE) depth++;
+		else if(token->type == T_END && depth > 0) depth--;
+
+		if(func != NULL){
+			// Pozice tokenů se do hashe nepočítají, kód na nich nezávisí
+			func->hash = hashFnv64(func->hash, &token->type, sizeof(tType));
+			if(token->data != NULL) func->hash = hashFnv64(func->hash, token->data, strlen(token->data) + 1);
+
+			if(depth == 0){
+				func->end = token;
+				func = NULL;
+			}
+		}
+	}
+	// Neuzavřená definice je syntaktická chyba, kód se nevypíše
+	if(func != NULL) incr->funcCount--;
+
+	incr->namesSize = 16;
+	while(incr->namesSize < 2 * (unsigned)incr->funcCount) incr->namesSize *= 2;
+	incr->names = safeMalloc(incr->namesSize * sizeof(tIncrFunc *));
+	memset(incr->names, 0, incr->namesSize * sizeof(tIncrFunc *));
+	for(int i = 0; i < incr->funcCount; i++){
+		unsigned index = incrementalNameIndex(incr->funcs[i].id);
+		incr->funcs[i].next = incr->names[index];
+		incr->names[index] = &incr->funcs[i];
+	}
+
+	// Přímo volané funkce každé definice (bez opakování), callees[first[i]..first[i + 1])
+	int *first = safeMalloc((incr->funcCount + 1) * sizeof(int));
+	int *callees = NULL;
+	int calleeCount = 0;
+	int calleeSize = 0;
+	int *seen = safeMalloc((incr->funcCount > 0 ? incr->funcCount : 1) * sizeof(int));
+	for(int i = 0; i < incr->funcCount; i++) seen[i] = -1;
+
+	for(int i = 0; i < incr->funcCount; i++){
+		first[i] = calleeCount;
+		for(token = incr->funcs[i].def; token != incr->funcs[i].end; token = token->nextToken){
+			if(token->type != T_ID) continue;
+			tIncrFunc *callee = incrementalFind(token->data);
+			if(callee == NULL || seen[callee - incr->funcs] == i) continue;
+			seen[callee - incr->funcs] = i;
+
+			if(calleeCount >= calleeSize){
+				calleeSize = calleeSize > 0 ? calleeSize * 2 : 64;
+				callees = safeRealloc(callees, calleeSize * sizeof(int));
+			}
+			callees[calleeCount++] = callee - incr->funcs;
+		}
+	}
+	first[incr->funcCount] = calleeCount;
+
+	/*
+	 * Otisk: sestavení překladače, nastavení, tokeny funkce a všech funkcí,
+	 * které volá přímo i nepřímo. Vložená funkce může mít vložené další
+	 * funkce, kód volající funkce tak závisí na celém grafu volání pod ní
+	 */
+	bool options[2] = { ctx->options.stackCalls, ctx->options.unchecked };
+	uint64_t identity = compilerIdentity();
+	int *stack = safeMalloc((incr->funcCount > 0 ? incr->funcCount : 1) * sizeof(int));
+	for(int i = 0; i < incr->funcCount; i++) seen[i] = -1;
+
+	for(int i = 0; i < incr->funcCount; i++){
+		func = &incr->funcs[i];
+		uint64_t hash = hashFnv64(HASH_FNV64_INIT, &identity, sizeof(identity));
+		hash = hashFnv64(hash, options, sizeof(options));
+		hash = hashFnv64(hash, &func->hash, sizeof(func->hash));
+
+		int top = 0;
+		stack[top++] = i;
+		seen[i] = i;
+		while(top > 0){
+			int caller = stack[--top];
+			for(int c = first[caller]; c < first[caller + 1]; c++){
+				tIncrFunc *callee = &incr->funcs[callees[c]];
+
+				// Vložit na místo volání lze jen funkci definovanou dřív
+				bool before = callees[c] < caller;
+				hash = hashFnv64(hash, callee->id, strlen(callee->id) + 1);
+				hash = hashFnv64(hash, &callee->hash, sizeof(callee->hash));
+				hash = hashFnv64(hash, &before, sizeof(before));
+
+				if(seen[callees[c]] != i){
+					seen[callees[c]] = i;
+					stack[top++] = callees[c];
+				}
+			}
+		}
+		func->fingerprint = hash;
+	}
+
+	free(stack);
+	free(seen);
+	free(callees);
+	free(first);
+
+	if(mkdir(ctx->options.incrementalDir, 0777) != 0 && errno != EEXIST)
+		fprintf(ctx->errors, "[INTERNAL] Cannot create directory %s\n", ctx->options.incrementalDir);
+}
+
+void incrementalDispose(){
+	free(ctx->incremental.funcs);
+	free(ctx->incremental.names);
+	memset(&ctx->incremental, 0, sizeof(tIncrState));
+}
+
+char *incrementalLookup(pToken def, pToken *end){
+	tIncrState *incr = &ctx->incremental;
+	incr->current = NULL;
+	if(incr->funcCount == 0) return NULL;
+
+	// Generátor prochází definice v pořadí
+	tIncrFunc *func = NULL;
+	if(incr->nextFunc < incr->funcCount && incr->funcs[incr->nextFunc].def == def){
+		func = &incr->funcs[incr->nextFunc++];
+	}else{
+		for(int i = 0; i < incr->funcCount && func == NULL; i++)
+			if(incr->funcs[i].def == def) func = &incr->funcs[i];
+	}
+	if(func == NULL) return NULL;
+
+	char *path = incrementalPath(func);
+	FILE *file = fopen(path, "rb");
+	free(path);
+	if(file == NULL){
+		incr->current = func;
+		return NULL;
+	}
+
+	size_t len = 0;
+	size_t size = 4096;
+	char *code = safeMalloc(size);
+	size_t got;
+	while((got = fread(code + len, 1, size - len - 1, file)) > 0){
+		len += got;
+		if(len + 1 == size){
+			size *= 2;
+			code = safeRealloc(code, size);
+		}
+	}
+	bool failed = ferror(file);
+	fclose(file);
+
+	if(failed || len == 0){
+		free(code);
+		incr->current = func;
+		return NULL;
+	}
+
+	code[len] = '\0';
+	*end = func->end;
+	return code;
+}
+
+void incrementalStore(const char *code){
+	tIncrState *incr = &ctx->incremental;
+	if(incr->current == NULL) return;
+
+	// Zápis přes dočasný soubor, souběžný překlad tak nenačte nedokončený kód
+	char *path = incrementalPath(incr->current);
+	char *tmp = safeMalloc(strlen(path) + 64);
+	sprintf(tmp, "%s.tmp.%ld.%p", path, (long)getpid(), (void *)ctx);
+	incr->current = NULL;
+
+	FILE *file = fopen(tmp, "wb");
+	if(file != NULL){
+		size_t len = strlen(code);
+		bool failed = fwrite(code, 1, len, file) != len;
+		if(fclose(file) != 0 || failed || rename(tmp, path) != 0)
+			remove(tmp);
+	}
+
+	free(tmp);
+	free(path);
+}
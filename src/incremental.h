@@ -0,0 +1,79 @@
+/**
+ * @file incremental.h
+ * 
+ * Znovupoužití kódu nezměněných funkcí z předchozích překladů
+ * 
+ * Každá funkce dostane otisk z tokenů mezi def a end a z otisků funkcí,
+ * které volá (včetně toho, jestli jsou definované dřív - jen takové lze vložit
+ * na místo volání). Kód funkcí, které se nevkládají, se ukládá do složky
+ * options.incrementalDir pod jménem otisku a při dalším překladu se místo
+ * generování jen načte.
+ * 
+ * IFJ Projekt 2018, Tým 13
+ * 
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+#pragma once
+#include <stdint.h>
+#include "scanner.h"
+
+/**
+ * Přípona uloženého kódu funkce
+ */
+#define INCREMENTAL_EXT ".func"
+
+/**
+ * Definice funkce ve zdrojovém kódu
+ */
+typedef struct IncrFunc{
+	char *id;					//!< Jméno funkce
+	pToken def;					//!< Token def
+	pToken end;					//!< Token end definice
+	uint64_t hash;				//!< Hash tokenů definice
+	uint64_t fingerprint;		//!< Otisk včetně volaných funkcí a nastavení překladu
+	struct IncrFunc *next;		//!< Další funkce se stejným indexem v tabulce jmen
+} tIncrFunc;
+
+/**
+ * Stav znovupoužití funkcí (součást kontextu překladače)
+ */
+typedef struct IncrState{
+	tIncrFunc *funcs;			//!< Definice funkcí v pořadí ve zdrojovém kódu
+	int funcCount;
+	tIncrFunc **names;			//!< Tabulka funkcí podle jména (rozptylová tabulka se zřetězením)
+	unsigned namesSize;
+	int nextFunc;				//!< Index definice, ke které generátor dojde jako další
+	tIncrFunc *current;			//!< Právě generovaná funkce (NULL = hlavní tělo nebo znovupoužitá funkce)
+} tIncrState;
+
+/**
+ * Spočítá otisky všech funkcí programu (jen pokud je nastavena složka options.incrementalDir)
+ * 
+ * @param token První token programu
+ */
+void incrementalInit(pToken token);
+
+/**
+ * Uvolní otisky funkcí
+ */
+void incrementalDispose();
+
+/**
+ * Najde uložený kód funkce začínající tokenem def
+ * 
+ * @param def Token def definice funkce
+ * @param end Uloží token end definice (jen pokud byl kód nalezen)
+ * @return char* Kód funkce (je nutné uvolnit přes free()), NULL = funkce se musí vygenerovat
+ */
+char *incrementalLookup(pToken def, pToken *end);
+
+/**
+ * Uloží kód právě vygenerované funkce (té, pro kterou incrementalLookup nenašel kód)
+ * 
+ * @param code Kód funkce včetně prologu a epilogu
+ */
+void incrementalStore(const char *code);
@@ -16,7 +16,73 @@
 #define SYNTAX_TESTS 11
 #define SEMANTIC_TESTS 13
 
-int main(/*int argc, char const *argv[]*/){
+int main(int argc, char const *argv[]){
+	tOptions options = { .stackCalls = false, .unchecked = false, .literalStats = false, .incrementalDir = NULL, .timePhases = false, .timePhasesJson = false, .perfCounters = false, .emitStats = false };
+
+	const char *batchDir = NULL; // Složka pro výstupy dávkového překladu
+	int jobs = 0; // Počet vláken dávky (0 = počet procesorů)
+	int firstFile = argc; // První zdrojový soubor dávky
+	bool server = false; // Spustit překladový server
+	const char *socketPath = NULL; // Socket serveru (NULL = stdin/stdout)
+	const char *cacheDir = NULL; // Složka cache přeložených programů
+	long cacheSize = CACHE_DEFAULT_SIZE; // Největší velikost cache
+	bool cacheStats = false; // Vypsat statistiku cache
+
+	for(int i = 1; i < argc; i++){
+		if(strcmp(argv[i], "--stack-calls") == 0){
+			options.stackCalls = true;
+		}else if(strcmp(argv[i], "--unchecked") == 0){
+			options.unchecked = true;
+		}else if(strcmp(argv[i], "--literal-stats") == 0){
+			options.literalStats = true;
+		}else if(strcmp(argv[i], "--time-phases") == 0){
+			options.timePhases = true;
+		}else if(strcmp(argv[i], "--time-phases=json") == 0){
+			options.timePhases = true;
+			options.timePhasesJson = true;
+		}else if(strcmp(argv[i], "--perf-counters") == 0){
+			options.timePhases = true;
+			options.perfCounters = true;
+		}else if(strcmp(argv[i], "--emit-stats") == 0){
+			options.emitStats = true;
+		}else if(strcmp(argv[i], "--incremental") == 0 && i + 1 < argc){
+			options.incrementalDir = argv[++i];
+		}else if(strcmp(argv[i], "--jobs") == 0 && i + 1 < argc){
+			jobs = atoi(argv[++i]);
+		}else if(strcmp(argv[i], "--batch") == 0 && i + 1 < argc){
+			batchDir = argv[++i];
+		}else if(strcmp(argv[i], "--server") == 0){
+			server = true;
+		}else if(strcmp(argv[i], "--server-socket") == 0 && i + 1 < argc){
+			server = true;
+			socketPath = argv[++i];
+		}else if(strcmp(argv[i], "--cache") == 0 && i + 1 < argc){
+			cacheDir = argv[++i];
+		}else if(strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc){
+			cacheSize = atol(argv[++i]);
+		}else if(strcmp(argv[i], "--cache-stats") == 0){
+			cacheStats = true;
+		}else if(batchDir != NULL && argv[i][0] != '-'){
+			// Zbytek argumentů jsou zdrojové soubory dávky
+			firstFile = i;
+			break;
+		}else{
+			fprintf(stderr, "[INTERNAL] Unknown option %s\n", argv[i]);
+			fprintf(stderr, "Usage: %s [--stack-calls] [--unchecked] [--literal-stats] [--time-phases[=json]] [--perf-counters] [--emit-stats] [--incremental dir] [--cache dir [--cache-size bytes] [--cache-stats]] < source.ifj > out.ifjcode\n", argv[0]);
+			fprintf(stderr, "       %s [options] [--jobs n] --batch out_dir file... | @file_list\n", argv[0]);
+			fprintf(stderr, "       %s [options] --server | --server-socket path\n", argv[0]);
+			return 99;
+		}
+	}
+
+	if(server)
+		return serverRun(&options, socketPath);
+
+	if(batchDir != NULL)
+		return batchCompile(&options, batchDir, &argv[firstFile], argc - firstFile, jobs);
+
+	if(cacheDir != NULL)
+		return cacheCompile(&options, cacheDir, cacheSize, cacheStats);
 
 	/*if(argc > 1){
 		if(strcmp(argv[1], "j32") == 0) return janchDebug();
@@ -27,16 +93,9 @@ int main(/*int argc, char const *argv[]*/){
 	}*/
 
 
-	pToken token;
-
-	int retval = scannerGetTokenList(&token, stdin);
-	
-	if(retval == 0){
-		generateBaseCode();
-		retval = parser(&token);
-	}
-
-	scannerFreeTokenList(&token);
+	pCompiler compiler = ifj18_create(&options);
+	int retval = ifj18_compile(compiler, stdin, stdout);
+	ifj18_destroy(compiler);
 
 	return retval;
 }
@@ -49,7 +108,7 @@ int vitaDebug(){
 	char c = ' ';
 	char test[30];
  	char testOut[30];
-    pToken token = NULL;
+    pCompiler compiler = ifj18_create(NULL);
 
 	for(int i = 0; i < SYNTAX_TESTS; i++){
 		printf("\033[1;33m");
@@ -76,12 +135,9 @@ int vitaDebug(){
 		
 	  	printf("\n\n");
 
-	  	scannerGetTokenList(&token, file_test[i]);
-	  	parser(&token);
+	  	ifj18_compile(compiler, file_test[i], stdout);
 	  	fclose(file_test[i]);
 	  	fclose(file_expected[i]);
-		scannerFreeTokenList(&token);
-		scannerFSM(NULL, NULL);
 		printf("\033[1;31m");
 		printf("\n________________END OF TEST_%d_________________|\n", i+1);
 		printf("\033[0m");
@@ -116,12 +172,9 @@ int vitaDebug(){
 
 	  	printf("\n\n");
 
-	  	scannerGetTokenList(&token, file_test[i]);
-	  	parser(&token);
+	  	ifj18_compile(compiler, file_test[i], stdout);
 	  	fclose(file_test[i]);
 	  	fclose(file_expected[i]);
-		scannerFreeTokenList(&token);
-		scannerFSM(NULL, NULL);
 		printf("\x1B[34m");
 		printf("\n________________END OF TEST_%d_________________|\n", i+1);
 		printf("\033[0m");
@@ -129,17 +182,17 @@ int vitaDebug(){
 		if(i < SEMANTIC_TESTS-1) printf("|\n|\n");
 	}
 
+	ifj18_destroy(compiler);
   return 0;
 }
 
 int yellDebug(){
 	FILE *source1 = fopen("tests/test-code.4", "r");
 
-	pToken token1 = NULL;
-	scannerGetTokenList(&token1, source1);
-	parser(&token1);
+	pCompiler compiler = ifj18_create(NULL);
+	ifj18_compile(compiler, source1, stdout);
+	ifj18_destroy(compiler);
 	fclose(source1);
-	scannerFreeTokenList(&token1);
 
 	return 0;
 }
@@ -147,13 +200,9 @@ int yellDebug(){
 int janchDebug(){
 	FILE *source = fopen("tests/test-input-2", "r");
 
-	pToken token;
-	int retval = scannerGetTokenList(&token, source);
-	if(retval == 0){
-		generateBaseCode();
-		retval = parser(&token);
-	}
-	scannerFreeTokenList(&token);
+	pCompiler compiler = ifj18_create(NULL);
+	int retval = ifj18_compile(compiler, source, stdout);
+	ifj18_destroy(compiler);
 	fclose(source);
 
 	return retval;
@@ -14,9 +14,14 @@
 #pragma once
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "parser.h"
 #include "scanner.h"
 #include "expressions.h"
+#include "ifj18.h"
+#include "batch.h"
+#include "server.h"
+#include "cache.h"
 
 /**
  * Hlavní funkce programu
@@ -25,7 +30,7 @@
  * @param argv Pole argumentů (první je cesta ke spuštěnému programu)
  * @return int Stavový kód programu
  */
-int main(/*int argc, char const *argv[]*/);
+int main(int argc, char const *argv[]);
 
 /**
  * Funkce pro debugování člena týmu xchalo16
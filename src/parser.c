@@ -13,6 +13,7 @@
 
 #include "parser.h"
 #include "expressions.h"
+#include "context.h"
 
 int parser(pToken *List){
 
@@ -39,6 +40,7 @@ int parser(pToken *List){
 	bool inFunc = false;	// Je-li true, jsme ve funkci
 	int inAux = 0;			// Semafor - za každý if/while ++, za každý END --
 
+	timingPhase(PHASE_PRERUN);
 	while(preRun != NULL){	// Sémantický pre-run, naplnění tabulky definicemi funkcí
 		parserSemanticsPreRun(&preRun, &funcTable, &error);	// Naplnění tabulky definicí funkcí
 		error = parserError(error, internalError, &preRun);
@@ -47,6 +49,7 @@ int parser(pToken *List){
 
 			// Úklid
 
+			timingPhase(PHASE_TEARDOWN);
 			symTabDispose(&varTable);
 			symTabDispose(&funcTable);
 			parserSyntaxStackDelete(&S);
@@ -56,6 +59,7 @@ int parser(pToken *List){
 		preRun = preRun->nextToken;
 	}
 
+	timingPhase(PHASE_PARSE);
 	while(token != NULL){	// Syntaktická analýza + Sémantická analýza
 
 		pToken prevToken = token;
@@ -77,8 +81,12 @@ int parser(pToken *List){
 			token = token->nextToken;
 		}
 
-		// Volání Klarušina generování kódu
-		codeFromToken(S->a[S->last], token, localTable);
+		// Volání Klarušina generování kódu (za koncem souboru je zásobník prázdný)
+		if(S->last >= 0){
+			timingEnter(PHASE_EMIT);
+			codeFromToken(S->a[S->last], token, localTable);
+			timingLeave(PHASE_EMIT);
+		}
 
 		error = parserError(error, internalError, &prevToken);
 
@@ -86,6 +94,7 @@ int parser(pToken *List){
 			
 			// Úklid
 
+			timingPhase(PHASE_TEARDOWN);
 			symTabDispose(&varTable);
 			symTabDispose(&funcTable);
 			parserSyntaxStackDelete(&S);
@@ -95,6 +104,7 @@ int parser(pToken *List){
 
 	// Úklid
 
+	timingPhase(PHASE_TEARDOWN);
 	symTabDispose(&varTable);
 	symTabDispose(&funcTable);
 	parserSyntaxStackDelete(&S);
@@ -103,68 +113,68 @@ int parser(pToken *List){
 
 int parserError(int error, int internalError, pToken *prevToken){
 	if(internalError == 1){
-		fprintf(stderr, "[INTERNAL] Fatal error - Unexpected token on stack\n");
+		fprintf(ctx->errors, "[INTERNAL] Fatal error - Unexpected token on stack\n");
 		return 99;
 	}
 
 	else if(internalError == 2){
-		fprintf(stderr, "[INTERNAL] Fatal error - Failed malloc\n");
+		fprintf(ctx->errors, "[INTERNAL] Fatal error - Failed malloc\n");
 		return 99;
 	}
 
 	else if(internalError == 3){
-		fprintf(stderr, "[INTERNAL] Fatal error - Stack underflow\n");
+		fprintf(ctx->errors, "[INTERNAL] Fatal error - Stack underflow\n");
 		return 99;
 	} 
 
 	else if(internalError != 0 && internalError != 1 && internalError != 2 && internalError != 3){
-		fprintf(stderr, "[INTERNAL] Fatal error - Something went terribly wrong\n");
+		fprintf(ctx->errors, "[INTERNAL] Fatal error - Something went terribly wrong\n");
 		return 99;
 	}
 
 	if(error){
 			if(error == 2){	// Syntax
-				fprintf(stderr, "[SYNTAX] Error on line %u:%u\n", (*prevToken)->linePos, (*prevToken)->colPos);
+				fprintf(ctx->errors, "[SYNTAX] Error on line %u:%u\n", (*prevToken)->linePos, (*prevToken)->colPos);
 				return 2;
 			}
 
 			else if(error == 11){	// Sémantika
-				fprintf(stderr, "[SEMANTIC] Error on line %u:%u - Attempted to redefine function\n", (*prevToken)->linePos, (*prevToken)->colPos);
+				fprintf(ctx->errors, "[SEMANTIC] Error on line %u:%u - Attempted to redefine function\n", (*prevToken)->linePos, (*prevToken)->colPos);
 				return 3;
 			}
 
 			else if(error == 12){	// Sémantika
-				fprintf(stderr, "[SEMANTIC] Error on line %u:%u - Variables and functions must have different IDs\n", (*prevToken)->linePos, (*prevToken)->colPos);
+				fprintf(ctx->errors, "[SEMANTIC] Error on line %u:%u - Variables and functions must have different IDs\n", (*prevToken)->linePos, (*prevToken)->colPos);
 				return 3;
 			}
 
 			else if(error == 13){	// Sémantika
-				fprintf(stderr, "[SEMANTIC] Error on line %u:%u - Can't name a variable same as a previously defined function\n", (*prevToken)->linePos, (*prevToken)->colPos);
+				fprintf(ctx->errors, "[SEMANTIC] Error on line %u:%u - Can't name a variable same as a previously defined function\n", (*prevToken)->linePos, (*prevToken)->colPos);
 				return 3;
 			}
 
 			else if(error == 14){	// Sémantika
-				fprintf(stderr, "[SEMANTIC] Error on line %u:%u - Calling an undefined function\n", (*prevToken)->linePos, (*prevToken)->colPos);
+				fprintf(ctx->errors, "[SEMANTIC] Error on line %u:%u - Calling an undefined function\n", (*prevToken)->linePos, (*prevToken)->colPos);
 				return 3;
 			}
 
 			else if(error == 15){	// Sémantika
-				fprintf(stderr, "[SEMANTIC] Error on line %u:%u - Function can't have another function as an argument\n", (*prevToken)->linePos, (*prevToken)->colPos);
+				fprintf(ctx->errors, "[SEMANTIC] Error on line %u:%u - Function can't have another function as an argument\n", (*prevToken)->linePos, (*prevToken)->colPos);
 				return 6;
 			}
 
 			else if(error == 16){	// Sémantika
-				fprintf(stderr, "[SEMANTIC] Error on line %u:%u - Wrong number of arguments in a function\n", (*prevToken)->linePos, (*prevToken)->colPos);
+				fprintf(ctx->errors, "[SEMANTIC] Error on line %u:%u - Wrong number of arguments in a function\n", (*prevToken)->linePos, (*prevToken)->colPos);
 				return 5;
 			}
 
 			else if(error == 17){	// Sémantika
-				fprintf(stderr, "[SEMANTIC] Error on line %u:%u - Undefined variable\n", (*prevToken)->linePos, (*prevToken)->colPos);
+				fprintf(ctx->errors, "[SEMANTIC] Error on line %u:%u - Undefined variable\n", (*prevToken)->linePos, (*prevToken)->colPos);
 				return 3;
 			}
 
 			else if(error == 18){	// Sémantika
-				fprintf(stderr, "[SEMANTIC] Error on line %u:%u - Can't have arguments of the same name in a function\n", (*prevToken)->linePos, (*prevToken)->colPos);
+				fprintf(ctx->errors, "[SEMANTIC] Error on line %u:%u - Can't have arguments of the same name in a function\n", (*prevToken)->linePos, (*prevToken)->colPos);
 				return 6;
 			}
 
@@ -181,17 +191,17 @@ int parserError(int error, int internalError, pToken *prevToken){
 			}
 
 			else if(error == 69){	// Syntax
-				fprintf(stderr, "[SYNTAX] Error - Only function names can end with \"!\" and \"?\" symbols!\n");
+				fprintf(ctx->errors, "[SYNTAX] Error - Only function names can end with \"!\" and \"?\" symbols!\n");
 				return 2;
 			}
 
 			else if(error == 42){	// Syntax
-				fprintf(stderr, "[SYNTAX] Error - Only variables can be used when defining parameters of a function!\n");
+				fprintf(ctx->errors, "[SYNTAX] Error - Only variables can be used when defining parameters of a function!\n");
 				return 2;
 			}
 
 			else{	// Nedefinovanej stav, nemělo by nikdy nastat
-				fprintf(stderr, "[INTERNAL] Fatal error - Unexplainable unbelievable problem!\n");
+				fprintf(ctx->errors, "[INTERNAL] Fatal error - Unexplainable unbelievable problem!\n");
 				return 99;
 			}
 		}
@@ -534,7 +544,9 @@ void parserSyntaxExpand(pSyntaxStack S, pToken *token, int *error, int *internal
 
 	else if(S->a[S->last] == N_EXPR_O){
 		*token = (*token)->prevToken;
+		timingEnter(PHASE_EXPR);
 		*error = exprParse(&(*token), localTable);	// Volání externí funkce ke zpracování výrazů
+		timingLeave(PHASE_EXPR);
 		if(error) 
 			*error = *error * 100;	// Pokud nula, stále nula, jinak 200, 300, 400
 
@@ -547,7 +559,9 @@ void parserSyntaxExpand(pSyntaxStack S, pToken *token, int *error, int *internal
 	}
 
 	else if(S->a[S->last] == N_EXPR){
+		timingEnter(PHASE_EXPR);
 		*error = exprParse(&(*token), localTable);	// Volání externí funkce ke zpracování výrazů
+		timingLeave(PHASE_EXPR);
 		if(error) 
 			*error = *error * 100;	// Pokud nula, stále nula, jinak 200, 300, 400
 
@@ -724,6 +738,9 @@ void parserSemanticsCheck(pToken token, pToken *func, psTree *funcTable, psTree
 			}
 
 			else symTabInsert(localTable, token->data, parserSemanticsInitData(VAR, NULL, 0, false));	// Pokud ne, definujeme
+
+			// Funkce bez parametrů měla prázdný rámec -> kořen stromu je nový
+			symTabSearch(funcTable, (*func)->data)->localFrame = *localTable;
 		}
 	}
 
@@ -802,6 +819,7 @@ void parserSemanticsCheck(pToken token, pToken *func, psTree *funcTable, psTree
 
 			if((*func)->linePos == token->linePos){		// Pokud jsou to definice proměnných v hlavičce funkce
 				symTabInsert(localTable, token->data, parserSemanticsInitData(VAR, NULL, 0, false));	// Zadefinujeme je do local rámce
+				symTabSearch(funcTable, (*func)->data)->localFrame = *localTable;
 
 				pToken aux = token->prevToken;
 				while(aux->type != T_LBRCKT){	// Zkontroluju předchozí, jestli se náhodou nevyskytujou duplicity
@@ -12,6 +12,7 @@
  */
 
 #include "scanner.h"
+#include "context.h"
 
 int scannerGetTokenList(pToken *firstToken, FILE *file){
 	pToken prevToken = NULL;
@@ -24,6 +25,7 @@ int scannerGetTokenList(pToken *firstToken, FILE *file){
 		else prevToken->nextToken = newToken;
 		newToken->prevToken = prevToken;
 		prevToken = newToken;
+		ctx->timing.tokens++;
 
 		if(ret != 0){
 			scannerFreeTokenList(&prevToken);
@@ -35,6 +37,12 @@ int scannerGetTokenList(pToken *firstToken, FILE *file){
 	return 0;
 }
 
+void scannerInit(){
+	ctx->scanner.linePos = 0;
+	ctx->scanner.colPos = 1;
+	ctx->scanner.currChar = EOL;
+}
+
 int scannerGetToken(pToken *token, FILE *file){
 	if(file == NULL) file = stdin;
 	if(token == NULL) return 99;
@@ -64,17 +72,10 @@ int scannerFSM(FILE *file, pToken token){
 	
 
 	bool isActive = true;
-	static unsigned int linePos = 0;
-	static unsigned int colPos = 1;
-	static int currChar = -2;
-	if(currChar == -2) currChar = EOL;
-
-	if(file == NULL){
-		linePos = 0;
-		colPos = 1;
-		currChar = -2;
-		return 0;
-	}
+	// Pozice ve vstupu je v kontextu překladače, během čtení tokenu v lokálních proměnných
+	unsigned int linePos = ctx->scanner.linePos;
+	unsigned int colPos = ctx->scanner.colPos;
+	int currChar = ctx->scanner.currChar;
 
 	token->type = T_UNKNOWN;
 	token->colPos = colPos;
@@ -392,6 +393,10 @@ int scannerFSM(FILE *file, pToken token){
 			break;
 	}
 
+	ctx->scanner.linePos = linePos;
+	ctx->scanner.colPos = colPos;
+	ctx->scanner.currChar = currChar;
+
 	return nextState == STATE_ERROR ? 1 : 0;
 }
 
@@ -456,75 +461,75 @@ void scannerFreeTokenList(pToken *token){
 }
 
 void scannerHandleError(sState state, char currChar, unsigned int line, unsigned int col){
-	fprintf(stderr, "[SCANNER] Error on line %d:%d - ", line, col);
+	fprintf(ctx->errors, "[SCANNER] Error on line %d:%d - ", line, col);
 	
 	switch(state){
 		case STATE_STR:
-			fprintf(stderr, "Expected printable ASCII char (>= 0x20) in string, found ");
+			fprintf(ctx->errors, "Expected printable ASCII char (>= 0x20) in string, found ");
 			break;
 		case STATE_STR2:
-			fprintf(stderr, "Expected '\"','n','t','s','x' or '\\' after '\\', found ");
+			fprintf(ctx->errors, "Expected '\"','n','t','s','x' or '\\' after '\\', found ");
 			break;
 		case STATE_STR3:
-			fprintf(stderr, "Expected a-f or digit after 'x', found ");
+			fprintf(ctx->errors, "Expected a-f or digit after 'x', found ");
 			break;
 		case STATE_INT0:
 		case STATE_OCT:
-			fprintf(stderr, "Integer in octal base must be represented with numbers 0-7, found digit ");
+			fprintf(ctx->errors, "Integer in octal base must be represented with numbers 0-7, found digit ");
 			break;
 		case STATE_BIN:
-			fprintf(stderr, "Exprected binary number after '0b' found ");
+			fprintf(ctx->errors, "Exprected binary number after '0b' found ");
 			break;
 		case STATE_BIN2:
-			fprintf(stderr, "Integer in binary must be represented with 0 or 1, found digit ");
+			fprintf(ctx->errors, "Integer in binary must be represented with 0 or 1, found digit ");
 			break;
 		case STATE_HEX:
-			fprintf(stderr, "Exprected hexadecimal number after '0x', found ");
+			fprintf(ctx->errors, "Exprected hexadecimal number after '0x', found ");
 			break;
 		case STATE_DBLE:
-			fprintf(stderr, "Expected digit after decimal point, found ");
+			fprintf(ctx->errors, "Expected digit after decimal point, found ");
 			break;
 		case STATE_EXP:
-			fprintf(stderr, "Expected digit or +,- sign in exponent, found ");
+			fprintf(ctx->errors, "Expected digit or +,- sign in exponent, found ");
 			break;
 		case STATE_EXP2:
-			fprintf(stderr, "Expected digit after +,- sign in exponent, found ");
+			fprintf(ctx->errors, "Expected digit after +,- sign in exponent, found ");
 			break;
 		case STATE_AND:
-			fprintf(stderr, "Expected '&' after '&', found ");
+			fprintf(ctx->errors, "Expected '&' after '&', found ");
 			break;
 		case STATE_OR:
-			fprintf(stderr, "Expected '|' after '|', found ");
+			fprintf(ctx->errors, "Expected '|' after '|', found ");
 			break;
 		case STATE_BCMT7:
 		case STATE_BCMT8:
 		case STATE_BCMT9:
 		case STATE_BCMT10:
 		case STATE_BCMT11:
-			fprintf(stderr, "Expected \"=end\", found ");
+			fprintf(ctx->errors, "Expected \"=end\", found ");
 			break;
 		default:
-			fprintf(stderr, "Unexpected ");
+			fprintf(ctx->errors, "Unexpected ");
 			break;
 	}
 	
 	if(currChar >= 0x20){
-		fprintf(stderr, "'%c'", currChar);
+		fprintf(ctx->errors, "'%c'", currChar);
 	}else if(currChar == EOL || currChar == '\r'){
-		fprintf(stderr, "EOL");
+		fprintf(ctx->errors, "EOL");
 	}else if(currChar == EOF){
-		fprintf(stderr, "EOF");
+		fprintf(ctx->errors, "EOF");
 	}else{
-		fprintf(stderr, "0x%x", currChar);
+		fprintf(ctx->errors, "0x%x", currChar);
 	}
 	
 	if((currChar == '\r' || currChar == EOL) && state == STATE_STR){
-		fprintf(stderr, "; Did you forget to terminate the string?");
+		fprintf(ctx->errors, "; Did you forget to terminate the string?");
 	}else if(state == STATE_INT0) 
-		fprintf(stderr, " after '0'");
+		fprintf(ctx->errors, " after '0'");
 	else if(state >= STATE_BCMT7 && state <= STATE_BCMT11) 
-		fprintf(stderr, "; Reached end of file but block comment is still opened");
-	fprintf(stderr, "\n");
+		fprintf(ctx->errors, "; Reached end of file but block comment is still opened");
+	fprintf(ctx->errors, "\n");
 }
 
 const char *scannerTypeToString(tType type){
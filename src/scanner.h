@@ -161,6 +161,21 @@ typedef struct Token{
 	struct Token *nextToken;	//!< Ukazatel na další token v listu
 } *pToken;
 
+/**
+ * Pozice lexikálního analyzátoru ve vstupu (součást kontextu překladače)
+ */
+typedef struct ScanState{
+	unsigned int linePos;	//!< Aktuální řádek
+	unsigned int colPos;	//!< Aktuální pozice na řádku
+	int currChar;			//!< Načtený znak, který ještě nebyl zpracován
+} tScanState;
+
+
+/**
+ * Připraví lexikální analyzátor na čtení nového vstupu
+ */
+void scannerInit();
+
 
 /**
  * Načte všechny tokeny ze souboru
@@ -227,10 +242,6 @@ void scannerPrintTokenList(pToken token);
  * podle grafu v dokumentaci. Tato funkce neodlilšuje mezi
  * id a keyword a vrací všechny data bez modifikací
  * 
- * Speciální chování:
- * Pokud parametr file je nastavený na NULL, funkce resetuje
- * statické proměnné, lze použít při testování
- * 
  * @param file Ukzatel na soubor, ze kterého se má číst
  * @param token Token který má být vyplněn daty
  * @return int Stav operace - 0, pokud vše proběhlo v pořádku, 
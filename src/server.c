@@ -0,0 +1,210 @@
+/**
+ * @file server.c
+ * 
+ * Překladový server - opakovaný překlad v jednom dlouho běžícím procesu
+ * 
+ * IFJ Projekt 2018, Tým 13
+ * 
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+// fmemopen(), open_memstream() a sockety jsou součástí POSIX
+#define _POSIX_C_SOURCE 200809L
+#include "server.h"
+#include "common.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * Přečte přesně len bajtů
+ * 
+ * @return bool Data se podařilo přečíst (false při konci vstupu nebo chybě)
+ */
+static bool serverRead(int fd, void *data, size_t len){
+	char *pos = data;
+	while(len > 0){
+		ssize_t got = read(fd, pos, len);
+		if(got < 0 && errno == EINTR) continue;
+		if(got <= 0) return false;
+		pos += got;
+		len -= got;
+	}
+	return true;
+}
+
+/**
+ * Zapíše přesně len bajtů
+ * 
+ * @return bool Data se podařilo zapsat
+ */
+static bool serverWrite(int fd, const void *data, size_t len){
+	const char *pos = data;
+	while(len > 0){
+		ssize_t put = write(fd, pos, len);
+		if(put < 0 && errno == EINTR) continue;
+		if(put <= 0) return false;
+		pos += put;
+		len -= put;
+	}
+	return true;
+}
+
+/**
+ * Zapíše číslo jako 4 bajty big-endian
+ */
+static bool serverWriteU32(int fd, uint32_t value){
+	unsigned char bytes[4] = { value >> 24, value >> 16, value >> 8, value };
+	return serverWrite(fd, bytes, 4);
+}
+
+/**
+ * Zapíše blok dat s délkou
+ */
+static bool serverWriteBlock(int fd, const char *data, size_t len){
+	return serverWriteU32(fd, len) && serverWrite(fd, data, len);
+}
+
+/**
+ * Obslouží jedno spojení - překládá požadavky, dokud druhá strana neuzavře vstup
+ */
+static void serverSession(const tOptions *options, int inFd, int outFd){
+	pCompiler compiler = ifj18_create(options);
+
+	// Buffer pro zdrojový kód se mezi požadavky jen zvětšuje
+	char *source = NULL;
+	size_t sourceSize = 0;
+
+	unsigned char header[4];
+	while(serverRead(inFd, header, 4)){
+		uint32_t len = (uint32_t)header[0] << 24 | header[1] << 16 | header[2] << 8 | header[3];
+		if(len > SERVER_MAX_REQUEST){
+			// Zbytek požadavku se nečte, klient se ale dozví proč spojení končí
+			char message[96];
+			int messageLen = sprintf(message, "[INTERNAL] Request too large (%lu bytes, limit %u)\n",
+				(unsigned long)len, SERVER_MAX_REQUEST);
+			if(serverWriteU32(outFd, 99) && serverWriteBlock(outFd, NULL, 0))
+				serverWriteBlock(outFd, message, messageLen);
+			break;
+		}
+
+		if(len + 1 > sourceSize){
+			sourceSize = len + 1;
+			source = safeRealloc(source, sourceSize);
+		}
+		if(!serverRead(inFd, source, len)) break;
+
+		char *code = NULL;
+		size_t codeLen = 0;
+		char *errors = NULL;
+		size_t errorsLen = 0;
+		FILE *output = open_memstream(&code, &codeLen);
+		FILE *err = open_memstream(&errors, &errorsLen);
+		if(output == NULL || err == NULL){
+			fprintf(stderr, "[INTERNAL] Fatal error - cannot allocate memory\n");
+			exit(99);
+		}
+
+		int retval;
+		FILE *input = len > 0 ? fmemopen(source, len, "r") : fopen("/dev/null", "r");
+		if(input == NULL){
+			fprintf(err, "[INTERNAL] Cannot read request\n");
+			retval = 99;
+		}else{
+			ifj18_set_errors(compiler, err);
+			retval = ifj18_compile(compiler, input, output);
+			fclose(input);
+		}
+		fclose(output);
+		fclose(err);
+
+		bool sent = serverWriteU32(outFd, retval)
+			&& serverWriteBlock(outFd, code, codeLen)
+			&& serverWriteBlock(outFd, errors, errorsLen);
+
+		free(code);
+		free(errors);
+		if(!sent) break;
+	}
+
+	free(source);
+	ifj18_destroy(compiler);
+}
+
+/**
+ * Spojení přijaté na socketu
+ */
+typedef struct ServerClient{
+	const tOptions *options;	//!< Nastavení překladače
+	int fd;						//!< Socket spojení
+} tServerClient;
+
+/**
+ * Vlákno obsluhující jedno spojení na socketu
+ */
+static void *serverClientThread(void *arg){
+	tServerClient *client = arg;
+	serverSession(client->options, client->fd, client->fd);
+	close(client->fd);
+	free(client);
+	return NULL;
+}
+
+int serverRun(const tOptions *options, const char *socketPath){
+	// Klient, který spojení ukončí dřív, nesmí shodit celý server
+	signal(SIGPIPE, SIG_IGN);
+
+	if(socketPath == NULL){
+		serverSession(options, STDIN_FILENO, STDOUT_FILENO);
+		return 0;
+	}
+
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if(strlen(socketPath) >= sizeof(addr.sun_path)){
+		fprintf(stderr, "[INTERNAL] Socket path %s is too long\n", socketPath);
+		return 99;
+	}
+	strcpy(addr.sun_path, socketPath);
+
+	int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socketPath);
+	if(server < 0 || bind(server, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(server, SERVER_BACKLOG) != 0){
+		fprintf(stderr, "[INTERNAL] Cannot listen on %s\n", socketPath);
+		if(server >= 0) close(server);
+		return 99;
+	}
+
+	// Každé spojení má vlastní vlákno i kontext, server běží až do ukončení signálem
+	while(true){
+		int fd = accept(server, NULL, NULL);
+		if(fd < 0){
+			if(errno == EINTR || errno == ECONNABORTED) continue;
+			fprintf(stderr, "[INTERNAL] Cannot accept connection on %s\n", socketPath);
+			break;
+		}
+
+		tServerClient *client = safeMalloc(sizeof(tServerClient));
+		client->options = options;
+		client->fd = fd;
+
+		pthread_t thread;
+		if(pthread_create(&thread, NULL, serverClientThread, client) != 0){
+			close(fd);
+			free(client);
+			continue;
+		}
+		pthread_detach(thread);
+	}
+
+	close(server);
+	unlink(socketPath);
+	return 99;
+}
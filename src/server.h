@@ -0,0 +1,46 @@
+/**
+ * @file server.h
+ * 
+ * Překladový server - opakovaný překlad v jednom dlouho běžícím procesu
+ * 
+ * IFJ Projekt 2018, Tým 13
+ * 
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+#pragma once
+#include <stdint.h>
+#include "ifj18.h"
+
+/**
+ * Největší povolená délka zdrojového kódu v jednom požadavku
+ */
+#define SERVER_MAX_REQUEST (64u * 1024 * 1024)
+
+/**
+ * Počet čekajících spojení na socketu
+ */
+#define SERVER_BACKLOG 16
+
+/**
+ * Spustí překladový server. Každý požadavek je zdrojový kód s délkou:
+ * 
+ *     u32 délka, <délka> bajtů zdrojového kódu
+ * 
+ * a odpověď návratový kód překladu, vygenerovaný kód a chybová hlášení:
+ * 
+ *     u32 návratový kód, u32 délka kódu, kód, u32 délka hlášení, hlášení
+ * 
+ * Všechna čísla jsou v pořadí bajtů big-endian. Spojení končí uzavřením vstupu.
+ * Požadavek delší než SERVER_MAX_REQUEST se nepřečte, server odpoví návratovým
+ * kódem 99, prázdným kódem a hlášením "Request too large" a spojení uzavře.
+ * Kontext překladače se mezi požadavky jednoho spojení nevytváří znovu.
+ * 
+ * @param options Nastavení překladače
+ * @param socketPath Cesta k unix socketu, NULL = jedno spojení přes stdin/stdout
+ * @return int 0 po uzavření stdin, 99 pokud server nelze spustit
+ */
+int serverRun(const tOptions *options, const char *socketPath);
@@ -65,7 +65,7 @@ psData symTabSearch(psTree *tree, char *key){
 void symTabLefmostPre(psTree tree, psStack stack){
 	while(tree != NULL){
 		symStackPush(stack, tree);
-		printf("DEFVAR LF@%s\nMOVE LF@%s nil@nil\n", tree->key, tree->key);
+		outPrintf("DEFVAR LF@%s\nMOVE LF@%s nil@nil\n", tree->key, tree->key);
 		tree = tree->lptr;
 	}
 }
@@ -0,0 +1,308 @@
+/**
+ * @file timing.c
+ * 
+ * Měření doby jednotlivých fází překladu (--time-phases)
+ * 
+ * IFJ Projekt 2018, Tým 13
+ * 
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+// clock_gettime() je součástí POSIX, syscall() ne
+#define _DEFAULT_SOURCE
+#include "timing.h"
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include "context.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+/**
+ * Počet měření pro odhad doby čtení hodin
+ */
+#define TIMING_CALIBRATION 1000
+
+/**
+ * Počet sérií měření pro odhad doby čtení hodin
+ */
+#define TIMING_CALIBRATION_ROUNDS 5
+
+/**
+ * Názvy fází ve výpisu
+ */
+static const char *timingNames[PHASE_COUNT] = {
+	[PHASE_NONE] = "none",
+	[PHASE_READ] = "read",
+	[PHASE_SCAN] = "scan",
+	[PHASE_PRERUN] = "prerun",
+	[PHASE_PARSE] = "parse",
+	[PHASE_EXPR] = "expr",
+	[PHASE_EMIT] = "emit",
+	[PHASE_FLUSH] = "flush",
+	[PHASE_TEARDOWN] = "teardown"
+};
+
+/**
+ * Názvy čítačů ve výpisu
+ */
+static const char *timingCounterNames[COUNTER_COUNT] = {
+	[COUNTER_CYCLES] = "cycles",
+	[COUNTER_INSTRUCTIONS] = "instructions",
+	[COUNTER_BRANCH_MISSES] = "branch_misses",
+	[COUNTER_L1D_MISSES] = "l1d_misses",
+	[COUNTER_LLC_MISSES] = "llc_misses"
+};
+
+/**
+ * Otevře hardwarové čítače aktuálního vlákna (jen uživatelský režim, to
+ * povoluje i výchozí perf_event_paranoid). V kontejnerech a virtuálních
+ * strojích čítače často chybí, fáze se pak měří jen časem
+ */
+static void timingCountersOpen(){
+	tTiming *timing = &ctx->timing;
+#ifdef __linux__
+	static const struct { uint32_t type; uint64_t config; } events[COUNTER_COUNT] = {
+		[COUNTER_CYCLES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+		[COUNTER_INSTRUCTIONS] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+		[COUNTER_BRANCH_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+		[COUNTER_L1D_MISSES] = { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+			PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16 },
+		[COUNTER_LLC_MISSES] = { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL |
+			PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16 }
+	};
+
+	bool any = false;
+	for(tCounter counter = 0; counter < COUNTER_COUNT; counter++){
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = events[counter].type;
+		attr.config = events[counter].config;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		// Při nedostatku registrů se čítače střídají, hodnota se přepočte podle doby běhu
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		timing->counterFds[counter] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		if(timing->counterFds[counter] >= 0) any = true;
+		else if(timing->counterError == 0) timing->counterError = errno;
+	}
+	if(any) timing->counterError = 0;
+#else
+	timing->counterError = ENOSYS;
+#endif
+}
+
+/**
+ * Přičte stav čítačů od začátku fáze k fázi a uloží nový začátek
+ * 
+ * @param phase Končící fáze (PHASE_NONE = jen uložit začátek)
+ */
+static void timingCountersRead(tPhase phase){
+	tTiming *timing = &ctx->timing;
+	for(tCounter counter = 0; counter < COUNTER_COUNT; counter++){
+		uint64_t now[3];
+		if(timing->counterFds[counter] < 0 || read(timing->counterFds[counter], now, sizeof(now)) != sizeof(now)) continue;
+
+		uint64_t *start = timing->counterStart[counter];
+		uint64_t running = now[2] - start[2];
+		if(phase != PHASE_NONE && running > 0)
+			timing->counters[phase][counter] += (double)(now[0] - start[0]) * (now[1] - start[1]) / running;
+		memcpy(start, now, sizeof(now));
+	}
+}
+
+/**
+ * Aktuální čas hodin v sekundách
+ */
+static double timingClock(clockid_t clock){
+	struct timespec now;
+	clock_gettime(clock, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+void timingInit(){
+	memset(&ctx->timing, 0, sizeof(tTiming));
+	for(tCounter counter = 0; counter < COUNTER_COUNT; counter++) ctx->timing.counterFds[counter] = -1;
+	if(!ctx->options.timePhases) return;
+	if(ctx->options.perfCounters) timingCountersOpen();
+
+	// Vnořené fáze se měří i milionkrát za překlad, čtení hodin pak tvoří znatelnou část jejich doby.
+	// Nejkratší z několika sérií (první série navíc zahřeje cache)
+	ctx->timing.overhead = 1;
+	for(int round = 0; round < TIMING_CALIBRATION_ROUNDS; round++){
+		double start = timingClock(CLOCK_MONOTONIC);
+		for(int i = 0; i < TIMING_CALIBRATION; i++){
+			timingEnter(PHASE_NONE);
+			timingLeave(PHASE_NONE);
+		}
+		double overhead = (timingClock(CLOCK_MONOTONIC) - start) / TIMING_CALIBRATION;
+		if(overhead < ctx->timing.overhead) ctx->timing.overhead = overhead;
+	}
+	ctx->timing.wall[PHASE_NONE] = 0;
+	ctx->timing.calls[PHASE_NONE] = 0;
+}
+
+void timingPhase(tPhase phase){
+	if(!ctx->options.timePhases) return;
+	tTiming *timing = &ctx->timing;
+
+	double wall = timingClock(CLOCK_MONOTONIC);
+	double cpu = timingClock(CLOCK_THREAD_CPUTIME_ID);
+
+	if(timing->current != PHASE_NONE){
+		timing->wall[timing->current] += wall - timing->wallStart;
+		timing->cpu[timing->current] += cpu - timing->cpuStart;
+	}
+	timingCountersRead(timing->current);
+
+	timing->current = phase;
+	timing->wallStart = wall;
+	timing->cpuStart = cpu;
+}
+
+void timingEnter(tPhase phase){
+	(void)phase;
+	if(!ctx->options.timePhases) return;
+	ctx->timing.nestedStart = timingClock(CLOCK_MONOTONIC);
+}
+
+void timingLeave(tPhase phase){
+	if(!ctx->options.timePhases) return;
+	tTiming *timing = &ctx->timing;
+
+	timing->wall[phase] += timingClock(CLOCK_MONOTONIC) - timing->nestedStart;
+	timing->calls[phase]++;
+}
+
+/**
+ * Větší ze dvou čísel
+ */
+static double timingMax(double a, double b){
+	return a > b ? a : b;
+}
+
+/**
+ * Je fáze vnořená v PHASE_PARSE?
+ */
+static bool timingNested(tPhase phase){
+	return phase == PHASE_EXPR || phase == PHASE_EMIT;
+}
+
+/**
+ * Vypíše hodnoty čítačů fáze jako položky objektu JSON (nedostupný čítač = null)
+ */
+static void timingCountersJson(FILE *f, tPhase phase){
+	for(tCounter counter = 0; counter < COUNTER_COUNT; counter++){
+		if(ctx->timing.counterFds[counter] >= 0) fprintf(f, ",\"%s\":%.0f", timingCounterNames[counter], ctx->timing.counters[phase][counter]);
+		else fprintf(f, ",\"%s\":null", timingCounterNames[counter]);
+	}
+}
+
+/**
+ * Vypíše řádek tabulky čítačů (nedostupný čítač = n/a)
+ */
+static void timingCountersText(FILE *f, const char *name, tPhase phase){
+	tTiming *timing = &ctx->timing;
+	fprintf(f, "[PERF] %-14s", name);
+	for(tCounter counter = 0; counter < COUNTER_COUNT; counter++){
+		if(timing->counterFds[counter] >= 0) fprintf(f, " %14.0f", timing->counters[phase][counter]);
+		else fprintf(f, " %14s", "n/a");
+	}
+
+	double cycles = timing->counters[phase][COUNTER_CYCLES];
+	if(timing->counterFds[COUNTER_CYCLES] >= 0 && timing->counterFds[COUNTER_INSTRUCTIONS] >= 0 && cycles > 0)
+		fprintf(f, " %6.2f\n", timing->counters[phase][COUNTER_INSTRUCTIONS] / cycles);
+	else
+		fprintf(f, " %6s\n", "n/a");
+}
+
+void timingReport(){
+	if(!ctx->options.timePhases) return;
+	tTiming *timing = &ctx->timing;
+	FILE *f = ctx->errors;
+
+	// Doba čtení hodin vnořených fází se odečte od nich i od PHASE_PARSE, ve které proběhla
+	for(tPhase phase = PHASE_READ; phase < PHASE_COUNT; phase++){
+		if(!timingNested(phase)) continue;
+		double overhead = timing->calls[phase] * timing->overhead;
+		timing->wall[phase] = timingMax(timing->wall[phase] - overhead, 0);
+		timing->wall[PHASE_PARSE] = timingMax(timing->wall[PHASE_PARSE] - overhead, 0);
+		timing->cpu[PHASE_PARSE] = timingMax(timing->cpu[PHASE_PARSE] - overhead, 0);
+	}
+
+	// Součty se ukládají jako fáze PHASE_NONE
+	timing->wall[PHASE_NONE] = timing->cpu[PHASE_NONE] = 0;
+	for(tPhase phase = PHASE_READ; phase < PHASE_COUNT; phase++){
+		if(timingNested(phase)) continue;
+		timing->wall[PHASE_NONE] += timing->wall[phase];
+		timing->cpu[PHASE_NONE] += timing->cpu[phase];
+		for(tCounter counter = 0; counter < COUNTER_COUNT; counter++)
+			timing->counters[PHASE_NONE][counter] += timing->counters[phase][counter];
+	}
+	bool counters = ctx->options.perfCounters && timing->counterError == 0;
+	double wall = timing->wall[PHASE_NONE], cpu = timing->cpu[PHASE_NONE];
+
+	if(ctx->options.timePhasesJson){
+		fprintf(f, "{\"phases\":[");
+		for(tPhase phase = PHASE_READ; phase < PHASE_COUNT; phase++){
+			fprintf(f, "%s{\"name\":\"%s\",\"wall_ms\":%.3f,", phase == PHASE_READ ? "" : ",",
+				timingNames[phase], timing->wall[phase] * 1e3);
+			if(timingNested(phase)){
+				fprintf(f, "\"cpu_ms\":null,\"parent\":\"parse\",\"calls\":%lu}", timing->calls[phase]);
+			}else{
+				fprintf(f, "\"cpu_ms\":%.3f", timing->cpu[phase] * 1e3);
+				if(counters) timingCountersJson(f, phase);
+				fprintf(f, "}");
+			}
+		}
+		fprintf(f, "],\"total\":{\"wall_ms\":%.3f,\"cpu_ms\":%.3f", wall * 1e3, cpu * 1e3);
+		if(counters) timingCountersJson(f, PHASE_NONE);
+		fprintf(f, "},\"tokens\":%lu,\"bytes_in\":%zu,\"bytes_out\":%zu,\"clock_overhead_ns\":%.1f",
+			timing->tokens, timing->bytesIn, ctx->out.written, timing->overhead * 1e9);
+		if(ctx->options.perfCounters && !counters) fprintf(f, ",\"counters_error\":\"%s\"", strerror(timing->counterError));
+		fprintf(f, "}\n");
+		return;
+	}
+
+	fprintf(f, "[TIME] %-14s %10s %10s\n", "phase", "wall ms", "cpu ms");
+	for(tPhase phase = PHASE_READ; phase < PHASE_COUNT; phase++){
+		if(timingNested(phase)){
+			fprintf(f, "[TIME]   %-12s %10.3f %10s (%lu calls)\n", timingNames[phase],
+				timing->wall[phase] * 1e3, "-", timing->calls[phase]);
+		}else{
+			fprintf(f, "[TIME] %-14s %10.3f %10.3f\n", timingNames[phase],
+				timing->wall[phase] * 1e3, timing->cpu[phase] * 1e3);
+		}
+	}
+	fprintf(f, "[TIME] %-14s %10.3f %10.3f\n", "total", wall * 1e3, cpu * 1e3);
+	fprintf(f, "[TIME] %lu tokens, %zu bytes in, %zu bytes out\n", timing->tokens, timing->bytesIn, ctx->out.written);
+	fprintf(f, "[TIME] expr and emit exclude %.1f ns of clock overhead per call\n", timing->overhead * 1e9);
+
+	if(!ctx->options.perfCounters) return;
+	if(!counters){
+		fprintf(f, "[PERF] Hardware counters unavailable (%s), phases are measured by time only\n", strerror(timing->counterError));
+		return;
+	}
+
+	fprintf(f, "[PERF] %-14s", "phase");
+	for(tCounter counter = 0; counter < COUNTER_COUNT; counter++) fprintf(f, " %14s", timingCounterNames[counter]);
+	fprintf(f, " %6s\n", "IPC");
+	// Vnořené fáze se čítači neměří
+	for(tPhase phase = PHASE_READ; phase < PHASE_COUNT; phase++)
+		if(!timingNested(phase)) timingCountersText(f, timingNames[phase], phase);
+	timingCountersText(f, "total", PHASE_NONE);
+}
+
+void timingDispose(){
+	for(tCounter counter = 0; counter < COUNTER_COUNT; counter++){
+		if(ctx->timing.counterFds[counter] >= 0) close(ctx->timing.counterFds[counter]);
+		ctx->timing.counterFds[counter] = -1;
+	}
+}
@@ -0,0 +1,102 @@
+/**
+ * @file timing.h
+ * 
+ * Měření doby jednotlivých fází překladu (--time-phases)
+ * 
+ * IFJ Projekt 2018, Tým 13
+ * 
+ * @author <xforma14> Klára Formánková
+ * @author <xlanco00> Jan Láncoš
+ * @author <xsebel04> Vít Šebela
+ * @author <xchalo16> Jan Chaloupka
+ */
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Fáze překladu
+ */
+typedef enum{
+	PHASE_NONE,			//!< Žádná fáze neběží
+	PHASE_READ,			//!< Načtení vstupu do paměti
+	PHASE_SCAN,			//!< Lexikální analýza (scannerGetTokenList)
+	PHASE_PRERUN,		//!< Naplnění tabulky funkcí (parserSemanticsPreRun)
+	PHASE_PARSE,		//!< Syntaktická a sémantická analýza včetně výrazů a generování
+	PHASE_EXPR,			//!< Zpracování výrazů (exprParse), součást PHASE_PARSE
+	PHASE_EMIT,			//!< Generování kódu (codeFromToken), součást PHASE_PARSE
+	PHASE_FLUSH,		//!< Zápis zbytku výstupu
+	PHASE_TEARDOWN,		//!< Uvolnění tabulek symbolů, tokenů a stavu generátoru
+	PHASE_COUNT
+} tPhase;
+
+/**
+ * Hardwarové čítače měřené u fází (--perf-counters)
+ */
+typedef enum{
+	COUNTER_CYCLES,			//!< Takty procesoru
+	COUNTER_INSTRUCTIONS,	//!< Provedené instrukce
+	COUNTER_BRANCH_MISSES,	//!< Špatně předpovězené skoky
+	COUNTER_L1D_MISSES,		//!< Výpadky čtení z L1 datové cache
+	COUNTER_LLC_MISSES,		//!< Výpadky čtení z poslední úrovně cache
+	COUNTER_COUNT
+} tCounter;
+
+/**
+ * Naměřené doby fází (součást kontextu překladače)
+ */
+typedef struct Timing{
+	tPhase current;					//!< Právě měřená fáze
+	double wallStart;				//!< Začátek právě měřené fáze (monotónní čas v sekundách)
+	double cpuStart;				//!< Začátek právě měřené fáze (procesorový čas vlákna v sekundách)
+	double nestedStart;				//!< Začátek právě měřené vnořené fáze (monotónní čas v sekundách)
+	double wall[PHASE_COUNT];		//!< Celkový čas fází v sekundách
+	double cpu[PHASE_COUNT];		//!< Procesorový čas fází v sekundách (jen fáze, které nejsou vnořené)
+	unsigned long calls[PHASE_COUNT];	//!< Počet měření vnořené fáze
+	double overhead;				//!< Doba jednoho měření vnořené fáze (odečítá se ve výpisu)
+	int counterFds[COUNTER_COUNT];	//!< Deskriptory čítačů (-1 = čítač není k dispozici)
+	int counterError;				//!< Chyba při otevření čítačů (errno, 0 = alespoň jeden čítač běží)
+	uint64_t counterStart[COUNTER_COUNT][3];	//!< Stav čítačů na začátku fáze (hodnota, doba povolení, doba běhu)
+	double counters[PHASE_COUNT][COUNTER_COUNT];	//!< Hodnoty čítačů fází (přepočtené při sdílení čítačů)
+	unsigned long tokens;			//!< Počet tokenů
+	size_t bytesIn;					//!< Velikost vstupu
+} tTiming;
+
+/**
+ * Vynuluje měření, změří, kolik stojí čtení hodin, a otevře hardwarové čítače
+ * (volá se na začátku překladu)
+ */
+void timingInit();
+
+/**
+ * Ukončí právě měřenou fázi a začne měřit další
+ * 
+ * @param phase Další fáze (PHASE_NONE = konec měření)
+ */
+void timingPhase(tPhase phase);
+
+/**
+ * Začne měřit vnořenou fázi (PHASE_EXPR nebo PHASE_EMIT). Procesorový čas se
+ * u vnořených fází neměří, jeho čtení je o řád dražší než volání, které se měří
+ * 
+ * @param phase Vnořená fáze
+ */
+void timingEnter(tPhase phase);
+
+/**
+ * Ukončí měření vnořené fáze
+ * 
+ * @param phase Vnořená fáze (stejná jako u timingEnter)
+ */
+void timingLeave(tPhase phase);
+
+/**
+ * Vypíše naměřené doby do výpisu chyb a statistik (text nebo JSON podle nastavení)
+ */
+void timingReport();
+
+/**
+ * Zavře hardwarové čítače (volá se na konci překladu)
+ */
+void timingDispose();
@@ -0,0 +1,86 @@
+#!/bin/sh
+# Kontrola poctu vygenerovanych instrukci proti ulozenym baseline (--emit-stats)
+#
+# Pouziti: tests/emit-stats.sh [--update]
+#   --update   prepise baseline v tests/emit-stats/ aktualnimi pocty
+#   COMPILER   cesta k prekladaci (vychozi ./compiler)
+#   THRESHOLD  povoleny narust kazdeho poctu v procentech (vychozi 2)
+#
+# Kontroluji se vsechny programy v tests/, ktere se prelozi bez chyby. Skript
+# skonci chybou, kdyz nektery pocet (instrukce, volani pomocnych funkci,
+# CREATEFRAME a operace se zasobnikem u funkce, pocet operacniho kodu nebo
+# volani pomocne funkce) naroste o vic nez THRESHOLD procent, kdyz chybi
+# baseline prekladaneho programu nebo kdyz se program s baseline neprelozi.
+
+cd "$(dirname "$0")/.." || exit 1
+
+COMPILER=${COMPILER:-./compiler}
+THRESHOLD=${THRESHOLD:-2}
+BASELINES=tests/emit-stats
+UPDATE=0
+[ "$1" = "--update" ] && UPDATE=1
+
+TMP=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMP"' EXIT
+
+FAILED=0
+for PROGRAM in tests/test* tests/tests_sem/test* tests/tests_syn/test*; do
+	[ -f "$PROGRAM" ] || continue
+	case "$PROGRAM" in *.out|*.c|*.sh) continue ;; esac
+
+	NAME=$(echo "${PROGRAM#tests/}" | tr / -)
+	BASELINE="$BASELINES/$NAME.stats"
+
+	if ! $COMPILER --emit-stats < "$PROGRAM" > /dev/null 2> "$TMP/stats"; then
+		if [ -f "$BASELINE" ]; then
+			echo "$NAME: preklad selhal" >&2
+			FAILED=1
+		fi
+		continue
+	fi
+	grep '^\[EMIT\]' "$TMP/stats" > "$TMP/new"
+
+	if [ $UPDATE -eq 1 ]; then
+		mkdir -p "$BASELINES"
+		cp "$TMP/new" "$BASELINE"
+		echo "$NAME: baseline ulozena"
+		continue
+	fi
+
+	if [ ! -f "$BASELINE" ]; then
+		echo "$NAME: chybi baseline (tests/emit-stats.sh --update)" >&2
+		FAILED=1
+		continue
+	fi
+
+	# Klic radku je druh a jmeno (u souctu jen druh), zbytek jsou pocty
+	awk -v name="$NAME" -v threshold="$THRESHOLD" '
+		BEGIN { split("instrs helpers frames stack", metric, " ") }
+		$NF !~ /^[0-9]+$/ { next }
+		{
+			key = $2 == "total" ? $2 : $2 " " $3
+			first = $2 == "total" ? 3 : 4
+			counts = ""
+			for(i = first; i <= NF; i++) counts = counts " " $i
+		}
+		FNR == NR { base[key] = counts; next }
+		{
+			split(counts, new, " ")
+			split(key in base ? base[key] : "", old, " ")
+			for(i = 1; i in new; i++){
+				limit = (i in old ? old[i] : 0) * (1 + threshold / 100)
+				if(new[i] > limit){
+					printf "%s: %s %s %d -> %d\n", name, key, $2 == "opcode" || $2 == "helper" ? "count" : metric[i],
+						(i in old ? old[i] : 0), new[i]
+					grown = 1
+				}
+			}
+		}
+		END { exit grown }
+	' "$BASELINE" "$TMP/new" >&2 || FAILED=1
+done
+
+if [ $UPDATE -eq 0 ] && [ $FAILED -eq 0 ]; then
+	echo "Pocty instrukci v mezich baseline (+$THRESHOLD %)"
+fi
+exit $FAILED
@@ -0,0 +1,144 @@
+/**
+ * @file fuzz-string.c
+ * 
+ * Porovnání funkce stringToInterpret s původní implementací
+ * na náhodně generovaných řetězcových literálech
+ * 
+ * Použití: make fuzz (případně obj/fuzz-string [počet] [seed])
+ * 
+ * IFJ Projekt 2018, Tým 13
+ */
+
+#include "common.h"
+
+/**
+ * Původní implementace převodu literálu (referenční chování)
+ */
+static char *stringToInterpretRef(char *rawString){
+	int rawLen = strlen(rawString);
+	
+	int max = rawLen + 1;
+	int pos = 7;
+	char *out = safeMalloc(sizeof(char) * (max + 20));
+	strcpy(out, "string@");
+
+	for(int i = 1; i < rawLen - 1; i++){
+		if(max <= pos + 4){
+			max += 100;
+			out = safeRealloc(out, sizeof(char) * max);
+		}
+		
+		out[pos] = '\\';
+		if(rawString[i] == '\\'){
+			i++;
+			if(rawString[i] == '"'){
+				out[pos] = '"';
+				pos -= 3;
+			}else if(rawString[i] == 'n'){
+				out[pos+1] = '0';
+				out[pos+2] = '1';
+				out[pos+3] = '0';
+			}else if(rawString[i] == 't'){
+				out[pos+1] = '0';
+				out[pos+2] = '0';
+				out[pos+3] = '9';
+			}else if(rawString[i] == '\\'){
+				out[pos+1] = '0';
+				out[pos+2] = '9';
+				out[pos+3] = '2';
+			}else if(rawString[i] == 'x'){
+				int l = isxdigit(rawString[i+2])?2:1;
+				char hex[3] = {0};
+				hex[0] = rawString[i+1];
+				if(l > 1) hex[1] = rawString[i+2];
+				i += l;
+				sprintf(&out[pos+1], "%03ld", strtol(hex, NULL, 16));
+			}else{
+				out[pos+1] = '0';
+				out[pos+2] = '3';
+				out[pos+3] = '2';
+			}
+			pos += 3;
+		}else if(rawString[i] == '#'){
+			out[pos+1] = '0';
+			out[pos+2] = '3';
+			out[pos+3] = '5';
+			pos += 3;
+		}else if(rawString[i] <= ' '){
+			out[pos+1] = '0';
+			out[pos+2] = '3';
+			out[pos+3] = '2';
+			pos += 3;
+		}else{
+			out[pos] = rawString[i];
+		}
+
+		pos++;
+	}
+
+	out[pos] = '\0';
+	out = safeRealloc(out, sizeof(char) * (pos + 1));
+	return out;
+}
+
+/**
+ * Vygeneruje náhodný literál, který by přijal scanner (včetně uvozovek)
+ */
+static void fuzzLiteral(char *buf, int maxLen){
+	int len = rand() % 4 == 0 ? rand() % maxLen : rand() % 64;
+	int pos = 0;
+	const char *hex = "0123456789abcdefABCDEF";
+	const char *escapes = "\"nts\\";
+
+	buf[pos++] = '"';
+	while(pos < len){
+		int kind = rand() % 8;
+		if(kind == 0){
+			// Escape sekvence
+			buf[pos++] = '\\';
+			buf[pos++] = escapes[rand() % 5];
+		}else if(kind == 1){
+			// \xH nebo \xHH
+			buf[pos++] = '\\';
+			buf[pos++] = 'x';
+			buf[pos++] = hex[rand() % 22];
+			if(rand() % 2) buf[pos++] = hex[rand() % 22];
+		}else if(kind == 2){
+			// Dlouhý úsek běžných znaků (přes hranice bloků)
+			int run = rand() % 40;
+			for(int i = 0; i < run; i++) buf[pos++] = 'a' + rand() % 26;
+		}else{
+			// Libovolný bajt kromě \ a nuly
+			char c;
+			do c = (char)(1 + rand() % 255); while(c == '\\');
+			buf[pos++] = c;
+		}
+	}
+	buf[pos++] = '"';
+	buf[pos] = '\0';
+}
+
+int main(int argc, char const *argv[]){
+	int count = argc > 1 ? atoi(argv[1]) : 200000;
+	unsigned seed = argc > 2 ? (unsigned)atoi(argv[2]) : 1;
+	int maxLen = 4096;
+	char *buf = safeMalloc(maxLen + 64);
+
+	srand(seed);
+	for(int n = 0; n < count; n++){
+		fuzzLiteral(buf, maxLen);
+
+		char *expected = stringToInterpretRef(buf);
+		char *actual = stringToInterpret(buf);
+		if(strcmp(expected, actual) != 0){
+			fprintf(stderr, "Mismatch (seed %u, case %d)\ninput:    %s\nexpected: %s\nactual:   %s\n", seed, n, buf, expected, actual);
+			return 1;
+		}
+		free(expected);
+		free(actual);
+	}
+
+	printf("stringToInterpret: %d cases OK\n", count);
+	free(buf);
+	return 0;
+}
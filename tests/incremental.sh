@@ -0,0 +1,41 @@
+#!/bin/sh
+# Kontrola znovupouziti kodu funkci (--incremental) po zmene neprimo volane funkce
+#
+# Pouziti: tests/incremental.sh
+#   COMPILER   cesta k prekladaci (vychozi ./compiler)
+#
+# Prelozi tests/test-incremental-inline s prazdnou slozkou --incremental, pak
+# zmeni jen funkci h (vlozenou do g a pres g do f) a prelozi znovu. Vysledek
+# musi byt stejny jako pri uplnem prekladu zmeneneho programu.
+
+cd "$(dirname "$0")/.." || exit 1
+
+COMPILER=${COMPILER:-./compiler}
+PROGRAM=tests/test-incremental-inline
+
+TMP=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMP"' EXIT
+
+sed 's/x + 1$/x + 100/' "$PROGRAM" > "$TMP/changed.ifj"
+if cmp -s "$PROGRAM" "$TMP/changed.ifj"; then
+	echo "$PROGRAM: funkci h nejde zmenit" >&2
+	exit 1
+fi
+
+$COMPILER --incremental "$TMP/funcs" < "$PROGRAM" > "$TMP/first.code" || exit 1
+$COMPILER --incremental "$TMP/funcs" < "$PROGRAM" > "$TMP/reused.code" || exit 1
+$COMPILER --incremental "$TMP/funcs" < "$TMP/changed.ifj" > "$TMP/incremental.code" || exit 1
+$COMPILER < "$TMP/changed.ifj" > "$TMP/full.code" || exit 1
+
+FAILED=0
+if ! cmp -s "$TMP/first.code" "$TMP/reused.code"; then
+	echo "$PROGRAM: znovupouzity kod se lisi od puvodniho" >&2
+	FAILED=1
+fi
+if ! cmp -s "$TMP/incremental.code" "$TMP/full.code"; then
+	echo "$PROGRAM: po zmene h se inkrementalni preklad lisi od uplneho" >&2
+	FAILED=1
+fi
+
+[ $FAILED -eq 0 ] && echo "Inkrementalni preklad odpovida uplnemu"
+exit $FAILED